@@ -0,0 +1,126 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <jv/actor-system.hpp>
+#include <jv/bounded-poly.hpp>
+
+struct IMessage {
+    int rhs;
+    IMessage(int rhs_) noexcept : rhs(rhs_) {}
+
+    virtual ~IMessage() noexcept {}
+    virtual void move_to(void* dst) && noexcept = 0;
+    virtual void apply(int& lhs) const noexcept = 0;
+};
+
+struct Addition : IMessage {
+    using IMessage::IMessage; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs += rhs; }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) Addition(std::move(*this));
+    }
+};
+
+struct ExclusiveOr : IMessage {
+    using IMessage::IMessage; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs ^= rhs; }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) ExclusiveOr(std::move(*this));
+    }
+};
+
+using Message =
+    jv::BoundedPolyVM<std::aligned_union_t<0, Addition, ExclusiveOr>,
+                      IMessage, &IMessage::move_to>;
+
+struct IActor {
+    virtual ~IActor() noexcept {}
+    virtual void move_to(void* dst) && noexcept = 0;
+    virtual void receive(IMessage& message) noexcept = 0;
+};
+
+struct Accumulator : IActor {
+    int accum = 0;
+    std::atomic<int>* received;
+
+    Accumulator(std::atomic<int>& r) noexcept : received(&r) {}
+
+    void receive(IMessage& message) noexcept override {
+        message.apply(accum);
+        received->fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) Accumulator(std::move(*this));
+    }
+};
+
+using Actor = jv::BoundedPolyVM<std::aligned_union_t<0, Accumulator>, IActor,
+                                &IActor::move_to>;
+
+using System = jv::ActorSystem<Actor, Message, 1024>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+int main() {
+    constexpr int NbMessages = 10'000'000;
+    constexpr int Batch = 1000;
+
+    std::srand(std::time(nullptr));
+
+    // uncontended sends: the mailbox is drained on the same thread
+    {
+        std::atomic<int> received{0};
+        System system{1};
+        auto actor =
+            system.spawn(std::in_place_type_t<Accumulator>{}, received);
+        Seconds sending{0};
+        for (int i = 0; i < NbMessages; i += Batch) {
+            auto start = now();
+            for (int j = 0; j < Batch; ++j) {
+                if (j % 2)
+                    system.try_send(actor, Addition{rand()});
+                else
+                    system.try_send(actor, ExclusiveOr{rand()});
+            }
+            sending += now() - start;
+            system.run_pending();
+        }
+        std::cout << "Uncontended send took "
+                  << sending.count() / NbMessages * 1e9
+                  << " nanoseconds per message.\n";
+    }
+    // workers processing messages sent from the main thread
+    {
+        std::atomic<int> received{0};
+        System system{64};
+        for (int i = 0; i < 64; ++i)
+            system.spawn(std::in_place_type_t<Accumulator>{}, received);
+        unsigned nb_workers = std::max(1u, std::thread::hardware_concurrency());
+        system.start(nb_workers);
+        auto start = now();
+        for (int i = 0; i < NbMessages; ++i)
+            while (!system.try_send(i % 64, Addition{i}))
+                std::this_thread::yield();
+        while (received.load() < NbMessages)
+            std::this_thread::yield();
+        auto elapsed = now() - start;
+        system.stop();
+        std::cout << "Processing " << NbMessages << " messages on "
+                  << nb_workers << " workers took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <jv/any-range.hpp>
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// Not inlined, so that the erased range really crosses a boundary.
+[[gnu::noinline]] auto make_range(std::vector<int>& vec) -> jv::AnyRange<int> {
+    return jv::AnyRange<int>{vec};
+}
+
+int main() {
+    constexpr int NbElem = 100'000'000;
+
+    std::srand(std::time(nullptr));
+
+    std::vector<int> vec(NbElem);
+    for (auto& i : vec)
+        i = rand();
+
+    // direct iteration
+    {
+        int accum = 0;
+        auto start = now();
+        for (int i : vec)
+            accum ^= i;
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Direct iteration took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    // per-element virtual calls through AnyIterator
+    {
+        int accum = 0;
+        auto range = make_range(vec);
+        auto start = now();
+        for (int i : range)
+            accum ^= i;
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "AnyIterator iteration took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    // one virtual call per batch
+    {
+        int accum = 0;
+        auto range = make_range(vec);
+        auto start = now();
+        range.for_each<256>([&](int i) { accum ^= i; });
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "AnyRange::next_batch iteration took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
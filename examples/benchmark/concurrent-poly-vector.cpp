@@ -0,0 +1,116 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/concurrent-poly-vector.hpp>
+
+struct IUnaryOp {
+    int rhs;
+    IUnaryOp(int rhs_) noexcept : rhs(rhs_) {}
+
+    virtual ~IUnaryOp() noexcept {}
+    virtual void move_to(void* dst) && noexcept = 0;
+    virtual void apply(int& lhs) const noexcept = 0;
+};
+
+struct Addition : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs += rhs; }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) Addition(std::move(*this));
+    }
+};
+
+struct Substraction : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs -= rhs; }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) Substraction(std::move(*this));
+    }
+};
+
+struct ExclusiveOr : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs ^= rhs; }
+
+    void move_to(void* dst) && noexcept override {
+        new (dst) ExclusiveOr(std::move(*this));
+    }
+};
+
+using UnaryOp = jv::BoundedPolyVM<
+    std::aligned_union_t<0, Addition, Substraction, ExclusiveOr>, IUnaryOp,
+    &IUnaryOp::move_to>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+template <typename Push> void produce(int begin, int end, Push&& push) {
+    for (int i = begin; i < end; ++i) {
+        switch (i % 3) {
+        case 0: push(Addition{i}); break;
+        case 1: push(Substraction{i}); break;
+        case 2: push(ExclusiveOr{i}); break;
+        }
+    }
+}
+
+// Runs `NbThreads` producers, each appending its share of `NbOp` elements.
+template <typename Push>
+auto run_producers(int nb_threads, int nb_op, Push&& push) -> Seconds {
+    std::vector<std::thread> threads;
+    auto start = now();
+    for (int t = 0; t < nb_threads; ++t) {
+        int begin = nb_op / nb_threads * t;
+        int end = t + 1 == nb_threads ? nb_op : begin + nb_op / nb_threads;
+        threads.emplace_back([=, &push] { produce(begin, end, push); });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    return now() - start;
+}
+
+int main() {
+    constexpr int NbOp = 20'000'000;
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int nb_threads = 1; nb_threads <= max_threads; nb_threads *= 2) {
+        {
+            std::mutex mutex;
+            std::vector<UnaryOp> pipeline;
+            pipeline.reserve(NbOp);
+            auto elapsed =
+                run_producers(nb_threads, NbOp, [&](auto&& op) {
+                    std::lock_guard<std::mutex> lock{mutex};
+                    pipeline.push_back(std::move(op));
+                });
+            std::cout << nb_threads << " threads, mutex + std::vector took "
+                      << elapsed.count() << " seconds.\n";
+        }
+        {
+            jv::ConcurrentPolyVector<UnaryOp> pipeline;
+            pipeline.reserve(NbOp);
+            auto elapsed =
+                run_producers(nb_threads, NbOp, [&](auto&& op) {
+                    pipeline.push_back(std::move(op));
+                });
+            std::cout << nb_threads << " threads, ConcurrentPolyVector took "
+                      << elapsed.count() << " seconds.\n";
+        }
+    }
+}
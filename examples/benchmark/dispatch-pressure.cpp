@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+// Measures the cost of dispatch when caches are not warm, which is the usual
+// case in a service running many code paths between two calls:
+// - warm:   the elements are evaluated back to back
+// - cold:   the data caches are flushed between batches of elements
+// - icache: many unrelated functions are called between batches, which
+//           evicts the instruction cache and the branch predictors
+// Only the time spent evaluating the batches is counted. The sweep goes up
+// to 512 derived types, but std::variant stops at 128 alternatives: beyond,
+// it takes minutes to compile.
+
+// TYPES
+
+struct IOp {
+    unsigned rhs;
+    IOp(unsigned r) noexcept : rhs(r) {}
+    virtual ~IOp() noexcept {}
+    virtual void apply(unsigned& lhs) const noexcept = 0;
+};
+
+// One distinct type, and so one distinct function, per K.
+template <int K> struct Op final : IOp {
+    using IOp::IOp;
+    void apply(unsigned& lhs) const noexcept override {
+        lhs = lhs * (2 * K + 1) + rhs;
+    }
+};
+
+template <int K> struct VOp {
+    unsigned rhs;
+    void apply(unsigned& lhs) const noexcept { lhs = lhs * (2 * K + 1) + rhs; }
+};
+
+using Poly = jv::BoundedPoly<std::aligned_storage_t<16>, IOp>;
+
+constexpr int MaxVariantTypes = 128;
+
+template <typename Seq> struct VariantOf;
+template <int... K> struct VariantOf<std::integer_sequence<int, K...>> {
+    using type = std::variant<VOp<K>...>;
+};
+
+// no variant at all past MaxVariantTypes
+struct NoVariant {};
+
+template <int NbTypes>
+using VariantFor =
+    std::conditional_t<(NbTypes <= MaxVariantTypes),
+                       VariantOf<std::make_integer_sequence<int, NbTypes>>,
+                       std::enable_if<true, NoVariant>>;
+
+// EVICTION
+
+std::vector<unsigned char> flush_buffer(32 << 20); // bigger than L2 and most L3
+
+void flush_data_caches() {
+    for (std::size_t i = 0; i < flush_buffer.size(); i += 64)
+        flush_buffer[i] += 1;
+}
+
+template <int K> BENCH_NOINLINE void unrelated(unsigned& x) {
+    // enough distinct code to occupy a few cache lines per function
+    x = x * 2654435761u + K;
+    x ^= x >> 13;
+    if (x & 1)
+        x = x * 97 + K;
+    else
+        x = x / 3 + 7;
+    x ^= x << 5;
+    if (x % 7 == K % 7)
+        x += K * 31;
+}
+
+template <int... K>
+auto make_unrelated(std::integer_sequence<int, K...>) {
+    return std::vector<void (*)(unsigned&)>{&unrelated<K>...};
+}
+
+auto const unrelated_functions =
+    make_unrelated(std::make_integer_sequence<int, 1024>{});
+unsigned unrelated_sink = 0;
+
+void pollute_instruction_caches() {
+    for (auto* f : unrelated_functions)
+        f(unrelated_sink);
+}
+
+// BENCHMARK
+
+using Clock = std::chrono::steady_clock;
+
+enum class Mode { Warm, Cold, ICache };
+
+constexpr std::size_t NbElements = 1 << 20;
+constexpr std::size_t BatchSize = 64;
+constexpr std::size_t NbBatches = 256; // spread over the elements
+
+template <typename Container, typename Apply>
+auto time_per_element(Container const& elements, Mode mode, Apply apply)
+    -> double {
+    constexpr std::size_t Stride = NbElements / NbBatches;
+    unsigned accum = 0;
+    Clock::duration total{0};
+    for (std::size_t first = 0; first < NbElements; first += Stride) {
+        if (mode == Mode::Cold)
+            flush_data_caches();
+        else if (mode == Mode::ICache)
+            pollute_instruction_caches();
+        auto const start = Clock::now();
+        for (std::size_t i = first; i < first + BatchSize; ++i)
+            apply(elements[i], accum);
+        total += Clock::now() - start;
+    }
+    if (accum == 42)
+        std::cout << '!';
+    return std::chrono::duration<double, std::nano>(total).count() /
+           (NbBatches * BatchSize);
+}
+
+// Calls `f(std::integral_constant<int, kind>)`.
+template <typename F, int... K>
+void dispatch_kind(int kind, F& f, std::integer_sequence<int, K...>) {
+    static_cast<void>(
+        ((kind == K ? (f(std::integral_constant<int, K>{}), true) : false) ||
+         ...));
+}
+
+template <int NbTypes> void bench(Mode mode) {
+    using Indices = std::make_integer_sequence<int, NbTypes>;
+    using Variant = typename VariantFor<NbTypes>::type;
+    constexpr bool HasVariant = NbTypes <= MaxVariantTypes;
+
+    std::mt19937 rng{42};
+    std::vector<int> kinds(NbElements);
+    for (int& kind : kinds)
+        kind = int(rng() % NbTypes);
+
+    std::vector<Poly> polys;
+    std::vector<Variant> variants;
+    std::vector<std::unique_ptr<IOp>> pointers;
+    polys.reserve(NbElements);
+    variants.reserve(NbElements);
+    pointers.reserve(NbElements);
+    auto fill = [&](auto k) {
+        constexpr int K = decltype(k)::value;
+        polys.emplace_back(Op<K>{unsigned(rng())});
+        if constexpr (HasVariant)
+            variants.emplace_back(VOp<K>{unsigned(rng())});
+        pointers.push_back(std::make_unique<Op<K>>(unsigned(rng())));
+    };
+    for (int kind : kinds)
+        dispatch_kind(kind, fill, Indices{});
+
+    double const poly = time_per_element(
+        polys, mode, [](Poly const& p, unsigned& acc) { p->apply(acc); });
+    double variant = 0;
+    if constexpr (HasVariant)
+        variant = time_per_element(
+            variants, mode, [](Variant const& v, unsigned& acc) {
+                std::visit([&](auto const& op) { op.apply(acc); }, v);
+            });
+    double const pointer = time_per_element(
+        pointers, mode,
+        [](std::unique_ptr<IOp> const& p, unsigned& acc) { p->apply(acc); });
+
+    std::cout << std::setw(5) << NbTypes << " types:" << std::fixed
+              << std::setprecision(2) << "  BoundedPoly " << std::setw(6)
+              << poly << "ns  variant ";
+    if (HasVariant)
+        std::cout << std::setw(6) << variant << "ns";
+    else
+        std::cout << "     -  ";
+    std::cout << "  unique_ptr " << std::setw(6) << pointer << "ns\n";
+}
+
+int main() {
+    for (Mode mode : {Mode::Warm, Mode::Cold, Mode::ICache}) {
+        std::cout << (mode == Mode::Warm   ? "Warm caches"
+                      : mode == Mode::Cold ? "Cold data caches"
+                                           : "Polluted instruction caches")
+                  << ", time per element:\n";
+        bench<2>(mode);
+        bench<16>(mode);
+        bench<64>(mode);
+        bench<128>(mode);
+        bench<256>(mode);
+        bench<512>(mode);
+    }
+}
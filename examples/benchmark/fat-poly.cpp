@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/fat-poly.hpp>
+
+struct IUnaryOp {
+    int rhs;
+    IUnaryOp(int rhs_) noexcept : rhs(rhs_) {}
+
+    virtual ~IUnaryOp() noexcept {}
+    virtual auto apply(int lhs) const noexcept -> int = 0;
+};
+
+template <int K> struct Op final : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    auto apply(int lhs) const noexcept -> int override {
+        return (lhs ^ K) + rhs;
+    }
+};
+
+using Storage = std::aligned_storage_t<16, 8>;
+using UnaryOp = jv::BoundedPoly<Storage, IUnaryOp>;
+using FatUnaryOp = jv::FatPoly<Storage, IUnaryOp, &IUnaryOp::apply>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// A pipeline of `n` operations, drawn among `sizeof...(K)` types.
+template <typename T, int... K>
+auto build(int n, std::integer_sequence<int, K...>) -> std::vector<T> {
+    using Maker = T (*)(int);
+    Maker makers[] = {[](int rhs) -> T { return Op<K>{rhs}; }...};
+    std::srand(42);
+    std::vector<T> pipeline;
+    pipeline.reserve(n);
+    for (int i = 0; i < n; ++i)
+        pipeline.push_back(makers[std::rand() % sizeof...(K)](std::rand()));
+    return pipeline;
+}
+
+template <typename Types> void run(int n, int rounds, Types types) {
+    std::cout << types.size() << " types:\n";
+    {
+        std::vector<UnaryOp> pipeline = build<UnaryOp>(n, types);
+        int accum = 0;
+        auto start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (auto const& op : pipeline)
+                accum = op->apply(accum);
+        auto elapsed = now() - start;
+        std::cout << "  BoundedPoly virtual calls took " << elapsed.count()
+                  << " seconds (accum = " << accum << ").\n";
+    }
+    {
+        std::vector<FatUnaryOp> pipeline = build<FatUnaryOp>(n, types);
+        int accum = 0;
+        auto start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (auto const& op : pipeline)
+                accum = op.call<&IUnaryOp::apply>(accum);
+        auto elapsed = now() - start;
+        std::cout << "  FatPoly cached calls took " << elapsed.count()
+                  << " seconds (accum = " << accum << ").\n";
+    }
+}
+
+// usage: benchmark-fat-poly [nb operations] [nb rounds]
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 100'000;
+    int const rounds = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    run(n, rounds, std::make_integer_sequence<int, 3>{});
+    // the vtables no longer fit in L1: FatPoly saves a dependent miss
+    run(n, rounds, std::make_integer_sequence<int, 256>{});
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <jv/flat-expr-tree.hpp>
+
+// Classic pointer-based tree, for comparison.
+struct INode {
+    virtual ~INode() noexcept {}
+    virtual auto eval(double const* row) const -> double = 0;
+};
+
+struct Var : INode {
+    int column;
+    Var(int c) : column(c) {}
+    auto eval(double const* row) const -> double override {
+        return row[column];
+    }
+};
+
+template <typename F> struct Binary : INode {
+    std::unique_ptr<INode> lhs, rhs;
+    Binary(INode* l, INode* r) : lhs(l), rhs(r) {}
+    auto eval(double const* row) const -> double override {
+        return F{}(lhs->eval(row), rhs->eval(row));
+    }
+};
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+constexpr int NbColumns = 4;
+constexpr int Depth = 6; // 2^6 leaves
+
+auto make_pointer_tree(int depth, int& leaf) -> INode* {
+    if (depth == 0)
+        return new Var{leaf++ % NbColumns};
+    INode* lhs = make_pointer_tree(depth - 1, leaf);
+    INode* rhs = make_pointer_tree(depth - 1, leaf);
+    if (depth % 2)
+        return new Binary<std::plus<>>{lhs, rhs};
+    return new Binary<std::multiplies<>>{lhs, rhs};
+}
+
+auto make_flat_tree(jv::FlatExprTree<>::Builder& builder, int depth,
+                    int& leaf) -> jv::ExprRef {
+    if (depth == 0)
+        return builder.variable(leaf++ % NbColumns);
+    auto lhs = make_flat_tree(builder, depth - 1, leaf);
+    auto rhs = make_flat_tree(builder, depth - 1, leaf);
+    if (depth % 2)
+        return builder.function(std::plus<>{}, lhs, rhs);
+    return builder.function(std::multiplies<>{}, lhs, rhs);
+}
+
+int main() {
+    constexpr int NbRows = 1'000'000;
+
+    std::srand(std::time(nullptr));
+
+    std::vector<double> rows(NbRows * NbColumns);
+    for (auto& value : rows)
+        value = rand() / double(RAND_MAX);
+    std::vector<std::vector<double>> columns(NbColumns,
+                                             std::vector<double>(NbRows));
+    for (int r = 0; r < NbRows; ++r)
+        for (int c = 0; c < NbColumns; ++c)
+            columns[c][r] = rows[r * NbColumns + c];
+
+    int leaf = 0;
+    std::unique_ptr<INode> pointer_tree{make_pointer_tree(Depth, leaf)};
+    jv::FlatExprTree<>::Builder builder;
+    leaf = 0;
+    auto root = make_flat_tree(builder, Depth, leaf);
+    auto flat_tree = std::move(builder).build(root);
+
+    {
+        double accum = 0;
+        auto start = now();
+        for (int r = 0; r < NbRows; ++r)
+            accum += pointer_tree->eval(&rows[r * NbColumns]);
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Pointer tree evaluation took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    {
+        double accum = 0;
+        auto start = now();
+        for (int r = 0; r < NbRows; ++r)
+            accum += flat_tree.evaluate(&rows[r * NbColumns]);
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Flat tree evaluation took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    {
+        double const* column_ptrs[NbColumns];
+        for (int c = 0; c < NbColumns; ++c)
+            column_ptrs[c] = columns[c].data();
+        std::vector<double> out(NbRows);
+        auto start = now();
+        flat_tree.evaluate_batch(column_ptrs, NbRows, out.data());
+        double accum = 0;
+        for (double value : out)
+            accum += value;
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Flat tree batch evaluation took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
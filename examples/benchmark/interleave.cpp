@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/interleave.hpp>
+
+// the operations of benchmark-bounded-poly
+struct IUnaryOp {
+    int rhs;
+    IUnaryOp(int rhs_) noexcept : rhs(rhs_) {}
+
+    virtual ~IUnaryOp() noexcept {}
+    virtual void apply(int& lhs) const noexcept = 0;
+};
+
+struct Addition final : IUnaryOp {
+    using IUnaryOp::IUnaryOp;
+    void apply(int& lhs) const noexcept override { lhs += rhs; }
+};
+
+struct Substraction final : IUnaryOp {
+    using IUnaryOp::IUnaryOp;
+    void apply(int& lhs) const noexcept override { lhs -= rhs; }
+};
+
+struct ExclusiveOr final : IUnaryOp {
+    using IUnaryOp::IUnaryOp;
+    void apply(int& lhs) const noexcept override { lhs ^= rhs; }
+};
+
+using UnaryOp = jv::BoundedPoly<
+    std::aligned_union_t<0, Addition, Substraction, ExclusiveOr>, IUnaryOp>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// usage: benchmark-interleave [nb pipelines] [nb ops per pipeline]
+// Evaluates many small independent pipelines, one after the other, then
+// interleaved by k.
+int main(int argc, char** argv) {
+    int const nb_pipelines = argc > 1 ? std::atoi(argv[1]) : 10'000;
+    int const length = argc > 2 ? std::atoi(argv[2]) : 100;
+
+    std::srand(std::time(nullptr));
+    std::vector<std::vector<UnaryOp>> pipelines(nb_pipelines);
+    for (auto& pipeline : pipelines) {
+        pipeline.reserve(length);
+        for (int i = 0; i < length; ++i) {
+            switch (i % 3) {
+            case 0: pipeline.push_back(Addition{rand()}); break;
+            case 1: pipeline.push_back(Substraction{rand()}); break;
+            case 2: pipeline.push_back(ExclusiveOr{rand()}); break;
+            }
+        }
+    }
+
+    auto apply = [](UnaryOp const& op, int& accum) { op->apply(accum); };
+    auto report = [&](char const* name, auto const& accums, double seconds) {
+        int check = 0;
+        for (int accum : accums)
+            check ^= accum;
+        std::cout << name << seconds << " seconds (check " << check << ").\n";
+    };
+
+    // the best of a few rounds, with the pipelines in cache if they fit
+    auto measure = [&](char const* name, auto evaluate) {
+        double best = 1e9;
+        std::vector<int> accums;
+        for (int round = 0; round < 10; ++round) {
+            accums.assign(nb_pipelines, 0);
+            auto start = now();
+            evaluate(accums);
+            Seconds elapsed = now() - start;
+            best = std::min(best, elapsed.count());
+        }
+        report(name, accums, best);
+    };
+
+    measure("serial: ", [&](std::vector<int>& accums) {
+        for (int p = 0; p < nb_pipelines; ++p)
+            for (auto const& op : pipelines[p])
+                op->apply(accums[p]);
+    });
+    for (std::size_t k : {1, 2, 4, 8}) {
+        std::cout << "k = " << k << ": ";
+        measure("", [&](std::vector<int>& accums) {
+            jv::evaluate_interleaved(pipelines, accums, apply, k);
+        });
+    }
+    jv::InterleaveTuner tuner; // tuned by the first round only
+    measure("tuned: ", [&](std::vector<int>& accums) {
+        jv::evaluate_interleaved(pipelines, accums, apply, tuner);
+    });
+    std::cout << "tuned k = " << tuner.factor() << '\n';
+}
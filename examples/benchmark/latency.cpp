@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <jv/bounded-poly.hpp>
+#include <jv/ring-buffer.hpp>
+
+// Log-linear histogram in the manner of HdrHistogram: values are grouped by
+// power of two, and each power of two is split in 2^SubBits buckets, so the
+// relative error stays below 2^-SubBits at any magnitude.
+class Histogram {
+    static constexpr unsigned SubBits = 5;
+    static constexpr std::uint64_t SubCount = std::uint64_t{1} << SubBits;
+
+public:
+    Histogram() : counts_(64 * SubCount, 0) {}
+
+    void record(std::uint64_t value) {
+        ++counts_[index(value)];
+        ++total_;
+        max_ = std::max(max_, value);
+    }
+
+    auto max() const -> std::uint64_t { return max_; }
+
+    /// Smallest recorded value such that a fraction `p` of the values is
+    /// lower or equal, within the precision of the buckets.
+    auto percentile(double p) const -> std::uint64_t {
+        auto const rank = static_cast<std::uint64_t>(p * total_);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen > rank)
+                return value(i);
+        }
+        return value(counts_.size() - 1);
+    }
+
+private:
+    static auto index(std::uint64_t v) -> std::size_t {
+        if (v < SubCount)
+            return v;
+        unsigned msb = 0;
+        for (std::uint64_t x = v; x >>= 1;)
+            ++msb;
+        unsigned const shift = msb - SubBits;
+        return ((shift + 1) << SubBits) + ((v >> shift) - SubCount);
+    }
+
+    static auto value(std::size_t i) -> std::uint64_t {
+        if (i < SubCount)
+            return i;
+        unsigned const shift = unsigned(i >> SubBits) - 1;
+        return ((i & (SubCount - 1)) + SubCount) << shift;
+    }
+
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t total_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+void pin_to_cpu(unsigned cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    static_cast<void>(cpu);
+#endif
+}
+
+auto now_ns() -> std::int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct IMessage {
+    std::int64_t sent_ns;
+    IMessage(std::int64_t sent) noexcept : sent_ns(sent) {}
+    virtual ~IMessage() noexcept {}
+    virtual auto checksum() const noexcept -> unsigned = 0;
+};
+
+template <std::size_t Size> struct Message final : IMessage {
+    unsigned char payload[Size - sizeof(IMessage)];
+    Message(std::int64_t sent) noexcept : IMessage(sent) {
+        for (auto& byte : payload)
+            byte = static_cast<unsigned char>(sent);
+    }
+    auto checksum() const noexcept -> unsigned override {
+        return payload[0] + payload[sizeof(payload) - 1];
+    }
+};
+
+template <std::size_t Size>
+using Poly = jv::BoundedPoly<std::aligned_storage_t<Size>, IMessage>;
+
+constexpr std::size_t QueueCapacity = 1024;
+
+// TRANSPORTS
+// try_send(message) -> bool, try_receive(f(IMessage const&)) -> bool
+
+template <std::size_t Size> class MutexDeque {
+public:
+    template <typename M> auto try_send(M&& message) -> bool {
+        std::lock_guard<std::mutex> lock{mutex_};
+        queue_.emplace_back(std::forward<M>(message));
+        return true;
+    }
+    template <typename F> auto try_receive(F&& f) -> bool {
+        std::unique_lock<std::mutex> lock{mutex_};
+        if (queue_.empty())
+            return false;
+        Poly<Size> poly = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        f(*poly);
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<Poly<Size>> queue_;
+};
+
+template <std::size_t Size, template <typename, std::size_t> class Ring>
+class RingOf {
+public:
+    template <typename M> auto try_send(M&& message) -> bool {
+        return ring_.try_emplace(std::forward<M>(message));
+    }
+    template <typename F> auto try_receive(F&& f) -> bool {
+        return ring_.try_consume([&](Poly<Size>& poly) { f(*poly); });
+    }
+
+private:
+    Ring<Poly<Size>, QueueCapacity> ring_;
+};
+
+template <std::size_t Size> using Spsc = RingOf<Size, jv::SpscRing>;
+template <std::size_t Size> using Mpmc = RingOf<Size, jv::MpmcRing>;
+
+// Same SPSC ring, but each message is allocated on the heap.
+template <std::size_t Size> class UniquePtrSpsc {
+public:
+    template <typename M> auto try_send(M&& message) -> bool {
+        return ring_.try_emplace(
+            std::make_unique<std::decay_t<M>>(std::forward<M>(message)));
+    }
+    template <typename F> auto try_receive(F&& f) -> bool {
+        return ring_.try_consume(
+            [&](std::unique_ptr<IMessage>& ptr) { f(*ptr); });
+    }
+
+private:
+    jv::SpscRing<std::unique_ptr<IMessage>, QueueCapacity> ring_;
+};
+
+// Sends one message at a time, waiting for it to be received before sending
+// the next, so that the latency does not include time spent queued behind
+// other messages.
+template <std::size_t Size, typename Transport>
+void bench(char const* name, int nb_messages) {
+    constexpr int Warmup = 1000;
+    Transport transport;
+    Histogram histogram;
+    std::atomic<int> received{0};
+    unsigned checksum = 0;
+
+    std::thread consumer{[&] {
+        pin_to_cpu(1);
+        for (int i = 0; i < Warmup + nb_messages;) {
+            bool const got = transport.try_receive([&](IMessage const& m) {
+                std::int64_t const latency = now_ns() - m.sent_ns;
+                checksum += m.checksum();
+                if (i >= Warmup)
+                    histogram.record(std::uint64_t(latency));
+            });
+            if (got)
+                received.store(++i, std::memory_order_release);
+            else
+                std::this_thread::yield();
+        }
+    }};
+
+    pin_to_cpu(0);
+    for (int i = 0; i < Warmup + nb_messages; ++i) {
+        while (received.load(std::memory_order_acquire) != i)
+            std::this_thread::yield();
+        while (!transport.try_send(Message<Size>{now_ns()}))
+            std::this_thread::yield();
+    }
+    consumer.join();
+
+    std::cout << std::setw(14) << name << std::setw(6) << Size << " bytes"
+              << "  p50 " << std::setw(8) << histogram.percentile(0.5)
+              << "  p99 " << std::setw(8) << histogram.percentile(0.99)
+              << "  p99.9 " << std::setw(8) << histogram.percentile(0.999)
+              << "  max " << std::setw(8) << histogram.max()
+              << (checksum == 42 ? "!" : "") << '\n';
+}
+
+template <std::size_t Size> void bench_all(int nb_messages) {
+    bench<Size, MutexDeque<Size>>("mutex+deque", nb_messages);
+    bench<Size, Spsc<Size>>("SPSC ring", nb_messages);
+    bench<Size, Mpmc<Size>>("MPMC ring", nb_messages);
+    bench<Size, UniquePtrSpsc<Size>>("unique_ptr", nb_messages);
+}
+
+int main() {
+    constexpr int NbMessages = 200'000;
+    std::cout << "One-way latency in nanoseconds, threads pinned on CPUs 0 "
+                 "and 1\n";
+    bench_all<32>(NbMessages);
+    bench_all<128>(NbMessages);
+    bench_all<512>(NbMessages);
+}
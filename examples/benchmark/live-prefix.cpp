@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/uninitialized.hpp>
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const noexcept -> double = 0;
+};
+
+// 24 bytes with the vtable pointer
+struct Rect final : IShape {
+    float w, h, x, y;
+    Rect(float a, float b) noexcept : w(a), h(b), x(0), y(0) {}
+    auto area() const noexcept -> double override { return w * h; }
+};
+
+// rare, but it dictates the size of the storage
+struct Polygon final : IShape {
+    float points[56] = {};
+    auto area() const noexcept -> double override { return points[0]; }
+};
+
+using Shape = jv::BoundedPoly<std::aligned_storage_t<256, 8>, IShape>;
+
+template <> struct jv::is_trivially_relocatable<Shape> {
+    static constexpr bool value = true;
+};
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+template <typename Relocate>
+auto measure(Shape* a, Shape* b, int n, int rounds, Relocate relocate)
+    -> double {
+    auto start = now();
+    for (int r = 0; r < rounds; ++r) {
+        relocate(a, a + n, b);
+        std::swap(a, b);
+    }
+    Seconds elapsed = now() - start;
+    double area = 0;
+    for (int i = 0; i < n; ++i)
+        area += a[i]->area();
+    if (area < 0)
+        std::cout << area;
+    return elapsed.count();
+}
+
+// usage: benchmark-live-prefix [nb elements] [nb rounds]
+// Relocates the elements back and forth between two buffers, as a growing
+// container would, by copying either whole elements or their live prefix.
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 100'000;
+    // even, so that the elements end up in the first buffer
+    int const rounds = argc > 2 ? 2 * (std::atoi(argv[2]) / 2) : 100;
+
+    std::allocator<Shape> alloc;
+    Shape* a = alloc.allocate(n);
+    Shape* b = alloc.allocate(n);
+    for (int i = 0; i < n; ++i) {
+        if (i % 64 == 0)
+            new (a + i) Shape{Polygon{}};
+        else
+            new (a + i) Shape{Rect{1.f, float(i)}};
+    }
+
+    auto copy_whole = [](Shape* f, Shape* l, Shape* d) {
+        std::memcpy(static_cast<void*>(d), static_cast<void*>(f),
+                    (l - f) * sizeof(Shape));
+    };
+    double const whole = measure(a, b, n, rounds, copy_whole);
+    std::cout << "whole elements: " << whole << " seconds.\n";
+
+    auto copy_live = [](Shape* f, Shape* l, Shape* d) {
+        jv::uninitialized_relocate(f, l, d);
+    };
+    double const live = measure(a, b, n, rounds, copy_live);
+    std::cout << "live prefix:    " << live << " seconds.\n";
+
+    jv::destroy(a, a + n);
+    alloc.deallocate(a, n);
+    alloc.deallocate(b, n);
+}
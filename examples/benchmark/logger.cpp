@@ -0,0 +1,52 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+
+#include <jv/logger.hpp>
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// Discards everything, so that only formatting is measured.
+struct NullBuffer : std::streambuf {
+    auto overflow(int c) -> int override { return c; }
+};
+
+int main() {
+    constexpr int NbLines = 10'000'000;
+
+    std::srand(std::time(nullptr));
+    NullBuffer null_buffer;
+    std::ostream null_stream{&null_buffer};
+
+    // formatting on the hot thread
+    {
+        auto start = now();
+        for (int i = 0; i < NbLines; ++i)
+            null_stream << "request " << i << " took " << rand() << " us\n";
+        auto elapsed = now() - start;
+        std::cout << "Formatting in place took "
+                  << elapsed.count() / NbLines * 1e9
+                  << " nanoseconds per line.\n";
+    }
+    // deferred formatting
+    for (auto policy : {jv::OverflowPolicy::Drop, jv::OverflowPolicy::Block}) {
+        jv::Logger<> logger{null_stream, policy};
+        auto start = now();
+        for (int i = 0; i < NbLines; ++i)
+            JV_LOG(logger, "request {} took {} us", i, rand());
+        auto elapsed = now() - start;
+        std::cout << "Deferred logging ("
+                  << (policy == jv::OverflowPolicy::Drop ? "drop" : "block")
+                  << ") took " << elapsed.count() / NbLines * 1e9
+                  << " nanoseconds per line, " << logger.dropped()
+                  << " dropped.\n";
+    }
+}
@@ -0,0 +1,81 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <jv/multi-poly.hpp>
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const noexcept -> float = 0;
+};
+
+struct IWeighted {
+    virtual ~IWeighted() noexcept {}
+    virtual auto weight() const noexcept -> float = 0;
+};
+
+struct Circle final : IShape {
+    float radius;
+    Circle(float r) noexcept : radius(r) {}
+    auto area() const noexcept -> float override { return radius * radius; }
+};
+
+struct Plate final : IShape, IWeighted {
+    float side, density;
+    Plate(float s, float d) noexcept : side(s), density(d) {}
+    auto area() const noexcept -> float override { return side * side; }
+    auto weight() const noexcept -> float override {
+        return side * side * density;
+    }
+};
+
+using Shape = jv::MultiPoly<std::aligned_union_t<0, Circle, Plate>, IShape,
+                            IWeighted>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// usage: benchmark-multi-poly [nb shapes] [nb rounds]
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 10'000;
+    int const rounds = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+    std::srand(42);
+    std::vector<Shape> shapes;
+    shapes.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        if (std::rand() % 2)
+            shapes.emplace_back(Circle{1});
+        else
+            shapes.emplace_back(Plate{2, 0.5f});
+    }
+
+    {
+        float total = 0;
+        auto start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (Shape const& shape : shapes)
+                if (auto* w = dynamic_cast<IWeighted const*>(&shape.get()))
+                    total += w->weight();
+        auto elapsed = now() - start;
+        std::cout << "dynamic_cast took " << elapsed.count()
+                  << " seconds (total " << total << ").\n";
+    }
+    {
+        float total = 0;
+        auto start = now();
+        for (int r = 0; r < rounds; ++r)
+            for (Shape const& shape : shapes)
+                if (auto* w = shape.as<IWeighted>())
+                    total += w->weight();
+        auto elapsed = now() - start;
+        std::cout << "MultiPoly::as took " << elapsed.count()
+                  << " seconds (total " << total << ").\n";
+    }
+}
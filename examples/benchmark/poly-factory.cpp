@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-factory.hpp>
+#include <jv/poly-vector.hpp>
+
+struct IComponent {
+    virtual ~IComponent() noexcept {}
+    virtual auto cost() const noexcept -> double = 0;
+};
+
+template <int K> struct Component final : IComponent {
+    double value;
+    Component(double v) noexcept : value(v) {}
+    auto cost() const noexcept -> double override { return K * value; }
+};
+
+constexpr int NbTypes = 48;
+
+using Poly = jv::BoundedPoly<std::aligned_storage_t<16>, IComponent>;
+using Record = std::tuple<std::string, double>;
+
+auto name_of(int k) -> std::string {
+    return "component_type_" + std::to_string(k);
+}
+
+// What the configuration loader did: compares the name with each type.
+template <int... K>
+void create_with_compares(jv::PolyVector<Poly>& polys,
+                          std::vector<Record> const& records,
+                          std::integer_sequence<int, K...>) {
+    static std::string const names[] = {name_of(K)...};
+    polys.reserve(polys.size() + records.size());
+    for (auto const& [name, value] : records) {
+        bool const found =
+            ((name == names[K] ? (polys.emplace_back<Component<K>>(value),
+                                  true)
+                               : false) ||
+             ...);
+        if (!found)
+            std::abort();
+    }
+}
+
+template <int... K>
+void add_types(jv::PolyFactory<Poly, double>& factory,
+               std::integer_sequence<int, K...>) {
+    (factory.add<Component<K>>(name_of(K)), ...);
+}
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+// usage: benchmark-poly-factory [nb records]
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 2'000'000;
+    auto const types = std::make_integer_sequence<int, NbTypes>{};
+
+    std::srand(42);
+    std::vector<Record> records;
+    records.reserve(n);
+    for (int i = 0; i < n; ++i)
+        records.emplace_back(name_of(std::rand() % NbTypes), 1.0);
+
+    {
+        jv::PolyVector<Poly> polys;
+        auto start = now();
+        create_with_compares(polys, records, types);
+        auto elapsed = now() - start;
+        std::cout << "if/else chain of compares took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    {
+        jv::PolyFactory<Poly, double> factory;
+        add_types(factory, types);
+        factory.freeze();
+        jv::PolyVector<Poly> polys;
+        auto start = now();
+        factory.create_into(polys, records);
+        auto elapsed = now() - start;
+        std::cout << "PolyFactory::create_into took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/prefetch.hpp>
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto evaluate() const noexcept -> std::uint64_t = 0;
+};
+
+// Fills the whole storage, and reads its first and last cache lines.
+template <std::size_t Size, int Kind> struct Shape final : IShape {
+    std::uint64_t data[(Size - sizeof(void*)) / sizeof(std::uint64_t)];
+    Shape(std::uint64_t seed) noexcept {
+        for (auto& d : data)
+            d = seed++;
+    }
+    auto evaluate() const noexcept -> std::uint64_t override {
+        constexpr std::size_t N = sizeof(data) / sizeof(data[0]);
+        return data[0] * Kind + data[N - 1];
+    }
+};
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+template <typename T> auto deref(T const& value) -> T const& { return value; }
+template <typename T> auto deref(T const* value) -> T const& { return *value; }
+
+constexpr std::size_t WorkingSet = 256 << 20; // far bigger than caches
+
+template <std::size_t Size> void bench() {
+    using Poly = jv::BoundedPoly<std::aligned_storage_t<Size>, IShape>;
+    std::size_t const count = WorkingSet / sizeof(Poly);
+    std::vector<Poly> values;
+    values.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        switch (rand() % 3) {
+        case 0: values.emplace_back(Shape<Size, 1>{i}); break;
+        case 1: values.emplace_back(Shape<Size, 2>{i}); break;
+        default: values.emplace_back(Shape<Size, 3>{i}); break;
+        }
+    }
+
+    // the same elements, visited in a mixed order
+    std::vector<Poly const*> shuffled;
+    shuffled.reserve(count);
+    for (auto const& value : values)
+        shuffled.push_back(&value);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{42});
+
+    auto run = [&](char const* name, auto const& range) {
+        std::cout << name << ' ' << Size << " bytes:";
+        for (std::size_t distance : {0, 2, 4, 8, 16}) {
+            std::uint64_t accum = 0;
+            auto start = now();
+            jv::for_each_prefetch(
+                range,
+                [&](auto const& v) {
+                    accum += deref(v)->evaluate();
+                },
+                distance);
+            auto elapsed = now() - start;
+            std::cout << "  d=" << distance << ": "
+                      << elapsed.count() * 1e9 / count << "ns";
+            if (accum == 42)
+                std::cout << '!';
+        }
+        std::cout << '\n';
+    };
+    run("Sequential", values);
+    run("Shuffled  ", shuffled);
+}
+
+int main() {
+    std::srand(std::time(nullptr));
+    std::cout << "Time per element, by prefetch distance (0 = none)\n";
+    bench<16>();
+    bench<32>();
+    bench<64>();
+    bench<128>();
+    bench<256>();
+    bench<512>();
+}
@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-vector.hpp>
+#include <jv/reclaimer.hpp>
+#include <jv/thread-pool.hpp>
+
+struct INode {
+    virtual ~INode() noexcept {}
+    virtual auto size() const noexcept -> std::size_t = 0;
+};
+
+// owns memory on the heap, as most long-lived elements do
+struct Named final : INode {
+    std::unique_ptr<std::string> name;
+    Named(int i)
+        : name(std::make_unique<std::string>(64, char('a' + i % 26))) {}
+    auto size() const noexcept -> std::size_t override { return name->size(); }
+};
+
+using Node = jv::BoundedPoly<std::aligned_storage_t<16, 8>, INode>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+auto make_nodes(int n) -> jv::PolyVector<Node> {
+    jv::PolyVector<Node> nodes;
+    nodes.reserve(n);
+    for (int i = 0; i < n; ++i)
+        nodes.emplace_back<Named>(i);
+    return nodes;
+}
+
+// usage: benchmark-reclaimer [nb elements] [nb workers]
+// Time during which the caller is blocked by the destruction of a container.
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 2'000'000;
+    std::size_t const nb_workers =
+        argc > 2 ? std::atoi(argv[2])
+                 : std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    {
+        auto nodes = make_nodes(n);
+        auto start = now();
+        nodes = jv::PolyVector<Node>{};
+        Seconds elapsed = now() - start;
+        std::cout << "destructor:     " << elapsed.count() << " seconds.\n";
+    }
+    {
+        jv::ThreadPool pool{nb_workers};
+        auto nodes = make_nodes(n);
+        auto start = now();
+        nodes.clear(pool);
+        Seconds elapsed = now() - start;
+        std::cout << "parallel clear: " << elapsed.count() << " seconds ("
+                  << pool.size() << " threads).\n";
+    }
+    {
+        jv::Reclaimer reclaimer;
+        auto nodes = make_nodes(n);
+        auto start = now();
+        reclaimer.defer(std::move(nodes));
+        Seconds elapsed = now() - start;
+        std::cout << "deferred:       " << elapsed.count() << " seconds.\n";
+        reclaimer.flush();
+    }
+}
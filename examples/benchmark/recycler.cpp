@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/recycler.hpp>
+
+struct IStage {
+    virtual ~IStage() noexcept {}
+    virtual auto run(int x) -> int = 0;
+};
+
+// expensive to construct: a reserved buffer and a hash map
+struct Histogram final : IStage {
+    std::vector<int> samples;
+    std::unordered_map<int, int> counts;
+    Histogram(int reserve) {
+        samples.reserve(reserve);
+        counts.reserve(64);
+    }
+    Histogram(Histogram&&) noexcept = default;
+    void reset(int) {
+        samples.clear();
+        counts.clear();
+    }
+    auto run(int x) -> int override {
+        samples.push_back(x);
+        return ++counts[x % 64];
+    }
+};
+
+struct Scale final : IStage {
+    int factor;
+    Scale(int f) noexcept : factor(f) {}
+    auto run(int x) -> int override { return x * factor; }
+};
+
+using Stage = jv::BoundedPoly<std::aligned_storage_t<96, 8>, IStage>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+template <typename Replace>
+auto measure(std::vector<Stage>& stages, int rounds, Replace replace)
+    -> double {
+    auto start = now();
+    long sum = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (std::size_t i = 0; i < stages.size(); ++i) {
+            replace(stages[i], int(r + i));
+            sum += stages[i]->run(r);
+        }
+    }
+    Seconds elapsed = now() - start;
+    if (sum == 42)
+        std::cout << sum;
+    return elapsed.count();
+}
+
+// usage: benchmark-recycler [nb stages] [nb rounds]
+// Replaces stages over and over, half of them by a Histogram, which owns
+// buffers, either constructing new ones or reusing recycled ones.
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int const rounds = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int const reserve = 256;
+
+    std::vector<Stage> stages;
+    for (int i = 0; i < n; ++i)
+        stages.emplace_back(Scale{i});
+
+    double const fresh =
+        measure(stages, rounds, [&](Stage& stage, int k) {
+            if (k % 2 == 0)
+                stage = Histogram{reserve};
+            else
+                stage.emplace<Scale>(k);
+        });
+    std::cout << "constructed: " << fresh << " seconds.\n";
+
+    jv::Recycler<IStage, Histogram> recycler{std::size_t(n)};
+    double const recycled =
+        measure(stages, rounds, [&](Stage& stage, int k) {
+            if (k % 2 == 0)
+                stage.emplace_recycled<Histogram>(recycler, reserve);
+            else
+                stage.emplace_recycled<Scale>(recycler, k);
+        });
+    std::cout << "recycled:    " << recycled << " seconds.\n";
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <jv/sealed-poly.hpp>
+
+struct IUnaryOp {
+    int rhs;
+    IUnaryOp(int rhs_) noexcept : rhs(rhs_) {}
+
+    virtual ~IUnaryOp() noexcept {}
+    virtual void apply(int& lhs) const noexcept = 0;
+};
+
+struct Addition final : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs += rhs; }
+};
+
+struct Substraction final : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs -= rhs; }
+};
+
+struct ExclusiveOr final : IUnaryOp {
+    using IUnaryOp::IUnaryOp; // inheriting constructor
+
+    void apply(int& lhs) const noexcept override { lhs ^= rhs; }
+};
+
+using UnaryOp = jv::SealedPoly<IUnaryOp, Addition, Substraction, ExclusiveOr>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+int main() {
+    constexpr int NbOp = 100'000'000;
+
+    std::srand(std::time(nullptr));
+
+    std::vector<UnaryOp> pipeline;
+    pipeline.reserve(NbOp);
+
+    // building pipeline
+    {
+        auto start = now();
+        for (int i = 0; i < NbOp; ++i) {
+            switch (i % 3) {
+            case 0: pipeline.push_back(Addition{rand()}); break;
+            case 1: pipeline.push_back(Substraction{rand()}); break;
+            case 2: pipeline.push_back(ExclusiveOr{rand()}); break;
+            }
+        }
+        auto elapsed = now() - start;
+        std::cout << "Building pipeline took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    // evaluation pipeline, through Base
+    {
+        int accum = 0;
+        auto start = now();
+        for (auto const& op : pipeline)
+            op->apply(accum);
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Virtual evaluation pipeline took " << elapsed.count()
+                  << " seconds.\n";
+    }
+    // evaluation pipeline, through the concrete types
+    {
+        int accum = 0;
+        auto start = now();
+        jv::for_each(pipeline, [&](auto const& op) { op.apply(accum); });
+        auto elapsed = now() - start;
+        std::cout << "Result accum = " << accum << '\n';
+        std::cout << "Sealed evaluation pipeline took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+
+struct IStrategy {
+    virtual ~IStrategy() noexcept {}
+    virtual auto apply(double x) const noexcept -> double = 0;
+};
+
+struct Linear final : IStrategy {
+    double a, b;
+    Linear(double a_, double b_) noexcept : a(a_), b(b_) {}
+    auto apply(double x) const noexcept -> double override { return a * x + b; }
+};
+
+struct Quadratic final : IStrategy {
+    double a, b, c;
+    Quadratic(double a_, double b_, double c_) noexcept : a(a_), b(b_), c(c_) {}
+    auto apply(double x) const noexcept -> double override {
+        return (a * x + b) * x + c;
+    }
+};
+
+using Strategy = jv::BoundedPoly<std::aligned_storage_t<32>, IStrategy>;
+
+auto make_strategy(int version) -> Strategy {
+    if (version % 2)
+        return Strategy{Linear{1.0, double(version)}};
+    return Strategy{Quadratic{0.0, 1.0, double(version)}};
+}
+
+// SHARING STRATEGIES
+// read(f(IStrategy const&)) may be called from many threads,
+// replace(version) from a single writer thread.
+
+class WithMutex {
+public:
+    template <typename F> auto read(F&& f) -> double {
+        std::lock_guard<std::mutex> lock{mutex_};
+        return f(*strategy_);
+    }
+    void replace(int version) {
+        Strategy fresh = make_strategy(version);
+        std::lock_guard<std::mutex> lock{mutex_};
+        strategy_ = std::move(fresh);
+    }
+
+private:
+    std::mutex mutex_;
+    Strategy strategy_ = make_strategy(0);
+};
+
+class WithSharedMutex {
+public:
+    template <typename F> auto read(F&& f) -> double {
+        std::shared_lock<std::shared_mutex> lock{mutex_};
+        return f(*strategy_);
+    }
+    void replace(int version) {
+        Strategy fresh = make_strategy(version);
+        std::unique_lock<std::shared_mutex> lock{mutex_};
+        strategy_ = std::move(fresh);
+    }
+
+private:
+    std::shared_mutex mutex_;
+    Strategy strategy_ = make_strategy(0);
+};
+
+// The object is kept as its bytes, in atomic words: readers copy them with
+// relaxed loads and retry if a write overlapped, then use their copy. Only
+// valid because both strategies are trivially copyable apart from their
+// virtual pointer, so neither the words nor the copies need to be destroyed.
+class WithSeqlock {
+    static_assert(sizeof(Strategy) % sizeof(std::uint64_t) == 0);
+    static constexpr std::size_t NbWords =
+        sizeof(Strategy) / sizeof(std::uint64_t);
+
+public:
+    template <typename F> auto read(F&& f) -> double {
+        std::uint64_t words[NbWords];
+        for (;;) {
+            unsigned const before = sequence_.load(std::memory_order_acquire);
+            if (before % 2)
+                continue; // a write is in progress
+            for (std::size_t i = 0; i < NbWords; ++i)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before)
+                break;
+        }
+        std::aligned_storage_t<sizeof(Strategy), alignof(Strategy)> copy;
+        std::memcpy(&copy, words, sizeof(copy));
+        return f(*reinterpret_cast<Strategy const&>(copy));
+    }
+    void replace(int version) { store(make_strategy(version)); }
+
+    WithSeqlock() { store(make_strategy(0)); }
+
+private:
+    void store(Strategy const& strategy) {
+        std::uint64_t words[NbWords];
+        std::memcpy(words, static_cast<void const*>(&strategy), sizeof(words));
+        sequence_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < NbWords; ++i)
+            words_[i].store(words[i], std::memory_order_relaxed);
+        sequence_.fetch_add(1, std::memory_order_release);
+    }
+
+    std::atomic<unsigned> sequence_{0};
+    std::atomic<std::uint64_t> words_[NbWords] = {};
+};
+
+// Double buffering with per-reader announcements: the writer builds the next
+// object in the inactive slot once no reader announced it, then switches.
+class WithEpochs {
+    static constexpr int MaxReaders = 64;
+    struct alignas(64) Announce {
+        std::atomic<int> slot{-1};
+    };
+
+public:
+    template <typename F> auto read(F&& f) -> double {
+        thread_local int const id = next_id_.fetch_add(1) % MaxReaders;
+        Announce& announce = announces_[id];
+        int slot;
+        do {
+            slot = current_.load();
+            announce.slot.store(slot);
+        } while (current_.load() != slot);
+        double const result = f(*slots_[slot]);
+        announce.slot.store(-1, std::memory_order_release);
+        return result;
+    }
+    void replace(int version) {
+        int const next = 1 - current_.load();
+        for (auto& announce : announces_)
+            while (announce.slot.load() == next)
+                std::this_thread::yield();
+        slots_[next] = make_strategy(version);
+        current_.store(next);
+    }
+
+private:
+    Strategy slots_[2] = {make_strategy(0), make_strategy(0)};
+    std::atomic<int> current_{0};
+    Announce announces_[MaxReaders];
+    std::atomic<int> next_id_{0};
+};
+
+// C++17 has no std::atomic<std::shared_ptr>: the free atomic functions on
+// shared_ptr are what it specializes, and most implementations use a lock
+// pool for both.
+class WithSharedPtr {
+public:
+    template <typename F> auto read(F&& f) -> double {
+        std::shared_ptr<Strategy const> strategy = std::atomic_load(&strategy_);
+        return f(**strategy);
+    }
+    void replace(int version) {
+        std::atomic_store(&strategy_, std::shared_ptr<Strategy const>{
+                                          std::make_shared<Strategy>(
+                                              make_strategy(version))});
+    }
+
+private:
+    std::shared_ptr<Strategy const> strategy_ =
+        std::make_shared<Strategy>(make_strategy(0));
+};
+
+using Seconds = std::chrono::duration<double>;
+using Clock = std::chrono::steady_clock;
+
+struct alignas(64) ReaderCount {
+    std::uint64_t calls = 0;
+};
+
+template <typename Shared>
+void bench(char const* name, int nb_readers, Seconds write_period,
+           Seconds duration) {
+    Shared shared;
+    std::atomic<bool> stop{false};
+    std::vector<ReaderCount> counts(nb_readers);
+    std::vector<std::thread> readers;
+    for (int r = 0; r < nb_readers; ++r)
+        readers.emplace_back([&, r] {
+            double accum = 0;
+            std::uint64_t calls = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                accum += shared.read([&](IStrategy const& s) {
+                    return s.apply(double(calls));
+                });
+                ++calls;
+            }
+            counts[r].calls = calls + (accum == 42);
+        });
+
+    Seconds write_total{0}, write_max{0};
+    int writes = 0;
+    auto const start = Clock::now();
+    auto next_write = start;
+    while (Clock::now() - start < duration) {
+        if (Clock::now() < next_write) {
+            std::this_thread::yield();
+            continue;
+        }
+        auto const before = Clock::now();
+        shared.replace(++writes);
+        Seconds const latency = Clock::now() - before;
+        write_total += latency;
+        write_max = std::max(write_max, latency);
+        next_write = before +
+                     std::chrono::duration_cast<Clock::duration>(write_period);
+    }
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    std::uint64_t calls = 0;
+    for (auto const& count : counts)
+        calls += count.calls;
+    std::cout << std::setw(14) << name << std::setw(4) << nb_readers
+              << " readers: " << std::setw(9) << std::setprecision(4)
+              << calls / duration.count() / 1e6 << " M reads/s, writes "
+              << std::setw(8) << write_total.count() * 1e9 / std::max(writes, 1)
+              << "ns avg " << std::setw(9) << write_max.count() * 1e9
+              << "ns max\n";
+}
+
+// usage: benchmark-shared-strategy [seconds per run] [max readers]
+int main(int argc, char** argv) {
+    Seconds const duration{argc > 1 ? std::atof(argv[1]) : 0.1};
+    int const max_readers = argc > 2 ? std::atoi(argv[2]) : 64;
+
+    for (Seconds period : {Seconds{1e-3}, Seconds{1e-5}}) {
+        std::cout << "Writer replacing the strategy every "
+                  << period.count() * 1e6 << "us\n";
+        for (int n = 1; n <= max_readers; n *= 2) {
+            bench<WithMutex>("mutex", n, period, duration);
+            bench<WithSharedMutex>("shared_mutex", n, period, duration);
+            bench<WithSeqlock>("seqlock", n, period, duration);
+            bench<WithEpochs>("epochs", n, period, duration);
+            bench<WithSharedPtr>("shared_ptr", n, period, duration);
+        }
+    }
+}
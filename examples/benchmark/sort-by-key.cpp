@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/sort-by-key.hpp>
+
+struct IOrder {
+    std::uint32_t priority;
+    IOrder(std::uint32_t p) noexcept : priority(p) {}
+    virtual ~IOrder() noexcept {}
+    virtual auto cost() const noexcept -> double = 0;
+};
+
+struct Market final : IOrder {
+    double quantity;
+    Market(std::uint32_t p, double q) noexcept : IOrder(p), quantity(q) {}
+    auto cost() const noexcept -> double override { return quantity; }
+};
+
+struct Limit final : IOrder {
+    double quantity, price, stop[4] = {};
+    Limit(std::uint32_t p, double q, double pr) noexcept
+        : IOrder(p), quantity(q), price(pr) {}
+    auto cost() const noexcept -> double override { return quantity * price; }
+};
+
+using Order = jv::BoundedPoly<std::aligned_storage_t<64>, IOrder>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+auto make_orders(int n) -> std::vector<Order> {
+    std::srand(42);
+    std::vector<Order> orders;
+    orders.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        std::uint32_t const priority = std::uint32_t(rand()) * 7919u;
+        if (i % 3)
+            orders.emplace_back(Market{priority, 1.0});
+        else
+            orders.emplace_back(Limit{priority, 1.0, 2.0});
+    }
+    return orders;
+}
+
+// usage: benchmark-sort-by-key [nb elements]
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 10'000'000;
+
+    {
+        auto orders = make_orders(n);
+        auto start = now();
+        std::sort(orders.begin(), orders.end(),
+                  [](Order const& a, Order const& b) {
+                      return a->priority < b->priority;
+                  });
+        auto elapsed = now() - start;
+        std::cout << "std::sort took " << elapsed.count() << " seconds.\n";
+    }
+    {
+        auto orders = make_orders(n);
+        auto start = now();
+        jv::sort_by_key(orders, [](Order const& o) { return o->priority; });
+        auto elapsed = now() - start;
+        std::cout << "jv::sort_by_key took " << elapsed.count()
+                  << " seconds.\n";
+    }
+}
@@ -0,0 +1,91 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <jv/bounded-poly.hpp>
+#include <jv/vtable-mover.hpp>
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const noexcept -> float = 0;
+    virtual void move_to(void* dst) && noexcept = 0;
+};
+
+// move_to is only needed by VirtualMover
+template <typename Self> struct Shape : IShape {
+    void move_to(void* dst) && noexcept override {
+        new (dst) Self(std::move(static_cast<Self&>(*this)));
+    }
+};
+
+struct Circle final : Shape<Circle> {
+    float radius;
+    Circle(float r) noexcept : radius(r) {}
+    auto area() const noexcept -> float override { return radius * radius; }
+};
+
+struct Rectangle final : Shape<Rectangle> {
+    float width, height;
+    Rectangle(float w, float h) noexcept : width(w), height(h) {}
+    auto area() const noexcept -> float override { return width * height; }
+};
+
+struct Square final : Shape<Square> {
+    float side;
+    Square(float s) noexcept : side(s) {}
+    auto area() const noexcept -> float override { return side * side; }
+};
+
+using Storage = std::aligned_storage_t<16>;
+
+// std::chrono helpers
+using Seconds = std::chrono::duration<double>;
+
+using TimePoint =
+    std::chrono::time_point<std::chrono::high_resolution_clock, Seconds>;
+
+auto now() -> TimePoint { return std::chrono::high_resolution_clock::now(); }
+
+template <typename Poly> void run(char const* name, int n, int rounds) {
+    std::srand(42);
+    std::vector<Poly> shapes;
+    shapes.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        switch (std::rand() % 3) {
+        case 0: shapes.emplace_back(Circle{1}); break;
+        case 1: shapes.emplace_back(Rectangle{1, 2}); break;
+        case 2: shapes.emplace_back(Square{3}); break;
+        }
+    }
+    std::vector<Poly> other;
+    other.reserve(n);
+
+    auto start = now();
+    for (int r = 0; r < rounds; ++r) {
+        for (Poly& shape : shapes)
+            other.push_back(std::move(shape));
+        shapes.clear();
+        shapes.swap(other);
+    }
+    Seconds elapsed = now() - start;
+
+    float area = 0;
+    for (Poly const& shape : shapes)
+        area += shape->area();
+    std::cout << name << " (" << sizeof(Poly) << " bytes, area " << area
+              << "): moves took " << elapsed.count() << " seconds.\n";
+}
+
+// usage: benchmark-vtable-mover [nb elements] [nb rounds]
+int main(int argc, char** argv) {
+    int const n = argc > 1 ? std::atoi(argv[1]) : 100'000;
+    int const rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    run<jv::BoundedPoly<Storage, IShape>>("UniversalMover", n, rounds);
+    run<jv::BoundedPolyVM<Storage, IShape, &IShape::move_to>>(
+        "VirtualMover  ", n, rounds);
+    run<jv::BoundedPoly<Storage, IShape, jv::VtableMover<IShape>>>(
+        "VtableMover   ", n, rounds);
+}
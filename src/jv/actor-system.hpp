@@ -0,0 +1,348 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_ACTOR_SYSTEM_HPP
+#define JVERNAY_UTILS_ACTOR_SYSTEM_HPP
+
+#include <jv/ring-buffer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+namespace details {
+
+// Chase-Lev work-stealing deque of fixed capacity. The owner pushes and pops
+// at the bottom, thieves steal from the top. Fences follow Lê et al., "Correct
+// and Efficient Work-Stealing for Weak Memory Models" (2013).
+class WorkStealingDeque {
+public:
+  explicit WorkStealingDeque(std::size_t capacity)
+      : mask_{round_up(capacity) - 1},
+        buffer_{new std::atomic<std::uint32_t>[mask_ + 1]} {}
+
+  void push(std::uint32_t value) noexcept {
+    std::int64_t const b = bottom_.load(std::memory_order_relaxed);
+    buffer_[b & mask_].store(value, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  auto pop(std::uint32_t& value) noexcept -> bool {
+    std::int64_t const b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) { // empty
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    value = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) { // last element: race against thieves
+      bool const won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  auto steal(std::uint32_t& value) noexcept -> bool {
+    std::int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t const b = bottom_.load(std::memory_order_acquire);
+    if (t >= b)
+      return false;
+    value = buffer_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+private:
+  static auto round_up(std::size_t n) noexcept -> std::size_t {
+    std::size_t p = 2;
+    while (p < n)
+      p <<= 1;
+    return p;
+  }
+
+  std::size_t mask_;
+  std::unique_ptr<std::atomic<std::uint32_t>[]> buffer_;
+  alignas(64) std::atomic<std::int64_t> top_{0};
+  alignas(64) std::atomic<std::int64_t> bottom_{0};
+};
+
+} // namespace details
+
+/// Actor runtime where actors and their messages are stored inline.
+///
+/// Actors are `ActorPoly` objects (typically a `BoundedPoly`) living in an
+/// array allocated once at construction. Each actor owns a lock-free mailbox
+/// of `MailboxSize` inline `MessagePoly` slots, so sending a message never
+/// allocates. Actors with pending messages are scheduled on worker threads
+/// through work-stealing deques and process up to `BatchSize` messages per
+/// turn, by calling `actor->receive(*message)`.
+///
+/// An actor is scheduled at most once at a time, hence it is never run
+/// concurrently with itself and its mailbox has a single consumer. `receive`
+/// must not throw: an exception escaping a worker thread terminates.
+template <typename ActorPoly, typename MessagePoly,
+          std::size_t MailboxSize = 64, std::size_t BatchSize = 16>
+class ActorSystem {
+  static_assert(std::is_nothrow_destructible_v<ActorPoly>);
+
+  struct alignas(64) ActorSlot {
+    std::aligned_storage_t<sizeof(ActorPoly), alignof(ActorPoly)> actor;
+    std::atomic<bool> scheduled{false};
+    std::atomic<bool> constructed{false}; // published once `actor` is built
+    MpmcRing<MessagePoly, MailboxSize> mailbox;
+
+    auto get() noexcept -> ActorPoly& {
+      return reinterpret_cast<ActorPoly&>(actor);
+    }
+  };
+
+  struct Worker {
+    ActorSystem* system;
+    details::WorkStealingDeque deque;
+    std::thread thread;
+  };
+
+public:
+  using ActorId = std::uint32_t;
+
+  /// CONSTRUCTORS
+
+  /// Allocates the pool of `max_actors` actors and their mailboxes.
+  explicit ActorSystem(std::size_t max_actors)
+      : max_actors_{max_actors}, actors_{new ActorSlot[max_actors]},
+        injected_(max_actors) {}
+
+  ActorSystem(ActorSystem const&) = delete;
+  auto operator=(ActorSystem const&) -> ActorSystem& = delete;
+
+  /// DESTRUCTOR
+
+  /// Stops the workers, then destroys pending messages and every actor.
+  ~ActorSystem() noexcept {
+    stop();
+    std::size_t const spawned = spawned_.load(std::memory_order_acquire);
+    for (std::size_t id = 0; id < spawned; ++id)
+      if (actors_[id].constructed.load(std::memory_order_acquire))
+        actors_[id].get().~ActorPoly();
+  }
+
+  /// spawn
+
+  /// Constructs `ActorPoly(args...)` in the pool and returns its identifier.
+  /// Throws `std::length_error` if the pool is full. If the constructor
+  /// throws, the slot is given back, unless a later one was reserved
+  /// meanwhile: it then stays unused.
+  template <typename... Args> auto spawn(Args&&... args) -> ActorId {
+    std::size_t const id = spawned_.fetch_add(1, std::memory_order_acq_rel);
+    if (id >= max_actors_) {
+      spawned_.fetch_sub(1, std::memory_order_acq_rel);
+      throw std::length_error{"jv::ActorSystem: too many actors"};
+    }
+    ActorSlot& slot = actors_[id];
+    try {
+      new (&slot.actor) ActorPoly(std::forward<Args>(args)...);
+    } catch (...) {
+      std::size_t next = id + 1;
+      spawned_.compare_exchange_strong(next, id, std::memory_order_acq_rel);
+      throw;
+    }
+    slot.constructed.store(true, std::memory_order_release);
+    return static_cast<ActorId>(id);
+  }
+
+  /// actor
+
+  auto actor(ActorId id) noexcept -> ActorPoly& { return actors_[id].get(); }
+
+  /// try_send
+
+  /// Constructs `MessagePoly(args...)` in the mailbox of `to`, and schedules
+  /// the actor if it was idle. Returns `false` if the mailbox is full, and
+  /// throws `std::out_of_range` if `to` was not spawned, or is still being
+  /// constructed.
+  template <typename... Args>
+  auto try_send(ActorId to, Args&&... args) -> bool {
+    if (to >= spawned_.load(std::memory_order_acquire) ||
+        !actors_[to].constructed.load(std::memory_order_acquire))
+      throw std::out_of_range{"jv::ActorSystem: unknown actor"};
+    ActorSlot& slot = actors_[to];
+    if (!slot.mailbox.try_emplace(std::forward<Args>(args)...))
+      return false;
+    // pairs with the fence in `run_actor`: either the running worker sees
+    // this message, or we see that the actor is no longer scheduled
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!slot.scheduled.exchange(true, std::memory_order_acq_rel))
+      make_ready(to);
+    return true;
+  }
+
+  /// start
+
+  /// Launches `nb_workers` threads processing messages until `stop()`.
+  void start(std::size_t nb_workers) {
+    running_.store(true, std::memory_order_release);
+    workers_.reserve(nb_workers);
+    for (std::size_t i = 0; i < nb_workers; ++i)
+      workers_.push_back(std::unique_ptr<Worker>{
+          new Worker{this, details::WorkStealingDeque{max_actors_}, {}}});
+    for (std::size_t i = 0; i < nb_workers; ++i)
+      workers_[i]->thread = std::thread{[this, i] { work(i); }};
+  }
+
+  /// stop
+
+  /// Joins the workers. Messages which were not processed stay in the
+  /// mailboxes, and their actors are handed over to `run_pending`.
+  void stop() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      running_.store(false, std::memory_order_release);
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_)
+      if (worker->thread.joinable())
+        worker->thread.join();
+    for (auto& worker : workers_) {
+      std::uint32_t id;
+      while (worker->deque.pop(id))
+        inject(id);
+    }
+    workers_.clear();
+  }
+
+  /// run_pending
+
+  /// Runs ready actors on the calling thread until none is left, and returns
+  /// how many messages were processed. Useful without workers, or to drain
+  /// the system after `stop()`.
+  auto run_pending() -> std::size_t {
+    std::size_t processed = 0;
+    std::uint32_t id;
+    while (pop_injected(id))
+      processed += run_actor(id);
+    return processed;
+  }
+
+private:
+  // Current worker of the calling thread, if it belongs to any system.
+  static auto current_worker() noexcept -> Worker*& {
+    static thread_local Worker* worker = nullptr;
+    return worker;
+  }
+
+  void make_ready(ActorId id) {
+    Worker* worker = current_worker();
+    if (worker != nullptr && worker->system == this)
+      worker->deque.push(id);
+    else
+      inject(id);
+  }
+
+  // The injection queue receives actors made ready outside of the workers.
+  // It never holds more than `max_actors_` entries since an actor is queued
+  // at most once.
+  void inject(ActorId id) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      injected_[injected_end_++ % max_actors_] = id;
+    }
+    if (sleeping_.load(std::memory_order_acquire) > 0)
+      wakeup_.notify_one();
+  }
+
+  auto pop_injected(std::uint32_t& id) -> bool {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (injected_begin_ == injected_end_)
+      return false;
+    id = injected_[injected_begin_++ % max_actors_];
+    return true;
+  }
+
+  auto find_work(std::size_t self, std::uint32_t& id) -> bool {
+    if (workers_[self]->deque.pop(id) || pop_injected(id))
+      return true;
+    std::size_t const n = workers_.size();
+    for (std::size_t i = 1; i < n; ++i)
+      if (workers_[(self + i) % n]->deque.steal(id))
+        return true;
+    return false;
+  }
+
+  void work(std::size_t self) {
+    current_worker() = workers_[self].get();
+    unsigned idle = 0;
+    while (running_.load(std::memory_order_acquire)) {
+      std::uint32_t id;
+      if (find_work(self, id)) {
+        run_actor(id);
+        idle = 0;
+      } else if (++idle < 64) {
+        std::this_thread::yield();
+      } else {
+        // a short timeout bounds the latency of work pushed on another
+        // worker's deque, which does not notify sleepers
+        std::unique_lock<std::mutex> lock{mutex_};
+        sleeping_.fetch_add(1, std::memory_order_acq_rel);
+        if (running_.load(std::memory_order_acquire) &&
+            injected_begin_ == injected_end_)
+          wakeup_.wait_for(lock, std::chrono::milliseconds{1});
+        sleeping_.fetch_sub(1, std::memory_order_acq_rel);
+      }
+    }
+    current_worker() = nullptr;
+  }
+
+  auto run_actor(ActorId id) -> std::size_t {
+    ActorSlot& slot = actors_[id];
+    auto& actor = slot.get();
+    std::size_t processed = 0;
+    while (processed < BatchSize &&
+           slot.mailbox.try_consume(
+               [&](MessagePoly& message) { actor->receive(*message); }))
+      ++processed;
+    slot.scheduled.store(false, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!slot.mailbox.empty() &&
+        !slot.scheduled.exchange(true, std::memory_order_acq_rel))
+      make_ready(id);
+    return processed;
+  }
+
+  std::size_t max_actors_;
+  std::unique_ptr<ActorSlot[]> actors_;
+  std::atomic<std::size_t> spawned_{0};
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> running_{false};
+  std::atomic<int> sleeping_{0};
+  std::condition_variable wakeup_;
+
+  std::mutex mutex_; // protects the injection queue
+  std::vector<std::uint32_t> injected_;
+  std::size_t injected_begin_ = 0, injected_end_ = 0;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,189 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_ADAPTIVE_FILTER_CHAIN_HPP
+#define JVERNAY_UTILS_ADAPTIVE_FILTER_CHAIN_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+/// Interface of a predicate of `AdaptiveFilterChain`.
+template <typename Record> struct IFilter {
+  virtual ~IFilter() noexcept {}
+  virtual void move_to(void* dst) && noexcept = 0;
+  /// Returns `false` to reject the record.
+  virtual auto accept(Record const& record) const -> bool = 0;
+};
+
+/// Whether a filter may be reordered with its neighbours.
+enum class FilterOrder {
+  Free, ///< commutes with the other free filters of its segment
+  Fixed ///< stays in place, and no filter crosses it
+};
+
+/// Conjunction of filters, evaluated in order with early exit, which
+/// periodically reorders itself to minimize the expected cost per record.
+///
+/// One record every `sample_period` is evaluated by every free filter of each
+/// segment it reaches, measuring their cost and rejection rate. Every `reorder_period` records, each run of
+/// `FilterOrder::Free` filters between two `FilterOrder::Fixed` ones is sorted
+/// by increasing `cost / rejection rate`, which is the optimal order for
+/// independent filters, and the statistics are halved so that the chain keeps
+/// adapting to the traffic. Filters are `BoundedPoly` values, relocated by
+/// their mover when reordered.
+template <typename Record, typename Storage> class AdaptiveFilterChain {
+public:
+  using Filter =
+      BoundedPolyVM<Storage, IFilter<Record>, &IFilter<Record>::move_to>;
+
+private:
+  struct Stats {
+    double evaluations = 0;
+    double rejections = 0;
+    double nanoseconds = 0;
+  };
+
+  struct Element {
+    Filter filter;
+    FilterOrder order;
+    Stats stats;
+  };
+
+public:
+  /// CONSTRUCTORS
+
+  explicit AdaptiveFilterChain(std::size_t sample_period = 64,
+                               std::size_t reorder_period = 1 << 16) noexcept
+      : sample_period_{std::max<std::size_t>(sample_period, 1)},
+        reorder_period_{std::max<std::size_t>(reorder_period, 1)} {}
+
+  /// add
+
+  /// Appends a filter at the end of the chain.
+  template <typename Derived>
+  void add(Derived&& filter, FilterOrder order = FilterOrder::Free) {
+    elements_.push_back(
+        Element{Filter{std::forward<Derived>(filter)}, order, {}});
+  }
+
+  template <typename Derived, typename... Args>
+  void emplace(FilterOrder order, Args&&... args) {
+    elements_.push_back(Element{
+        Filter{std::in_place_type_t<Derived>{}, std::forward<Args>(args)...},
+        order,
+        {}});
+  }
+
+  /// accept
+
+  /// Returns `true` if every filter accepts `record`.
+  auto accept(Record const& record) -> bool {
+    if (++since_sample_ < sample_period_)
+      return accept_fast(record);
+    since_sample_ = 0;
+    bool const accepted = accept_sampled(record);
+    if ((samples_ += 1) * sample_period_ >= reorder_period_) {
+      samples_ = 0;
+      reorder();
+    }
+    return accepted;
+  }
+
+  /// reorder
+
+  /// Sorts each run of free filters by expected cost, using the statistics
+  /// gathered so far, then halves them.
+  void reorder() {
+    auto first = elements_.begin();
+    while (first != elements_.end()) {
+      auto last = std::find_if(first, elements_.end(), [](Element const& e) {
+        return e.order == FilterOrder::Fixed;
+      });
+      std::stable_sort(first, last, [](Element const& a, Element const& b) {
+        return rank(a.stats) < rank(b.stats);
+      });
+      first = last == elements_.end() ? last : last + 1;
+    }
+    for (Element& element : elements_) {
+      element.stats.evaluations /= 2;
+      element.stats.rejections /= 2;
+      element.stats.nanoseconds /= 2;
+    }
+  }
+
+  /// ELEMENT ACCESS
+
+  auto size() const noexcept -> std::size_t { return elements_.size(); }
+
+  /// Filter at position `index` in the current evaluation order.
+  auto operator[](std::size_t index) const noexcept -> Filter const& {
+    return elements_[index].filter;
+  }
+
+private:
+  // Expected cost of running this filter per record it rejects. Filters
+  // which were never sampled stay after the others.
+  static auto rank(Stats const& stats) noexcept -> double {
+    if (stats.evaluations == 0)
+      return std::numeric_limits<double>::infinity();
+    double const cost = stats.nanoseconds / stats.evaluations;
+    double const rejection_rate = stats.rejections / stats.evaluations;
+    return cost / std::max(rejection_rate, 1e-9);
+  }
+
+  auto accept_fast(Record const& record) const -> bool {
+    for (Element const& element : elements_)
+      if (!element.filter->accept(record))
+        return false;
+    return true;
+  }
+
+  // Evaluates every free filter of a segment, without early exit, so that
+  // the rejection rate of a filter does not depend on the filters placed
+  // before it in its segment. Segments are still evaluated with early exit:
+  // once a filter rejects, neither the next fixed filter nor anything after
+  // it runs, as they may rely on what was rejected being kept out.
+  auto accept_sampled(Record const& record) -> bool {
+    using Clock = std::chrono::steady_clock;
+    bool accepted = true;
+    auto before = Clock::now();
+    for (Element& element : elements_) {
+      if (!accepted && element.order == FilterOrder::Fixed)
+        break;
+      bool const ok = element.filter->accept(record);
+      auto const after = Clock::now();
+      element.stats.evaluations += 1;
+      element.stats.rejections += ok ? 0 : 1;
+      element.stats.nanoseconds +=
+          std::chrono::duration<double, std::nano>(after - before).count();
+      before = after;
+      accepted = accepted && ok;
+      if (!ok && element.order == FilterOrder::Fixed)
+        break;
+    }
+    return accepted;
+  }
+
+  std::vector<Element> elements_;
+  std::size_t const sample_period_;
+  std::size_t const reorder_period_;
+  std::size_t since_sample_ = 0;
+  std::size_t samples_ = 0;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,317 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_ANY_RANGE_HPP
+#define JVERNAY_UTILS_ANY_RANGE_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+template <typename T, std::size_t Size> struct AnyIteratorPoly;
+
+// Interface implemented by `IteratorModel` for each erased iterator type.
+template <typename T, std::size_t Size> struct IAnyIterator {
+  virtual ~IAnyIterator() noexcept {}
+  virtual void move_to(void* dst) && noexcept = 0;
+  virtual auto clone() const -> AnyIteratorPoly<T, Size> = 0;
+  virtual auto dereference() const -> T& = 0;
+  virtual void increment() = 0;
+  virtual void decrement() = 0;
+  virtual auto equal(IAnyIterator const& other) const -> bool = 0;
+  virtual auto singular() const noexcept -> bool { return false; }
+};
+
+template <typename T, std::size_t Size>
+struct AnyIteratorPoly
+    : BoundedPolyVM<std::aligned_storage_t<Size>, IAnyIterator<T, Size>,
+                    &IAnyIterator<T, Size>::move_to> {
+  using BoundedPolyVM<std::aligned_storage_t<Size>, IAnyIterator<T, Size>,
+                      &IAnyIterator<T, Size>::move_to>::BoundedPolyVM;
+};
+
+template <typename It, typename T, std::size_t Size>
+struct IteratorModel final : IAnyIterator<T, Size> {
+  It it;
+
+  IteratorModel(It i) noexcept(std::is_nothrow_move_constructible_v<It>)
+      : it(std::move(i)) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) IteratorModel(std::move(*this));
+  }
+
+  auto clone() const -> AnyIteratorPoly<T, Size> override {
+    return AnyIteratorPoly<T, Size>{std::in_place_type_t<IteratorModel>{},
+                                    *this};
+  }
+
+  auto dereference() const -> T& override { return *it; }
+
+  void increment() override { ++it; }
+
+  void decrement() override {
+    using Category = typename std::iterator_traits<It>::iterator_category;
+    if constexpr (std::is_base_of_v<std::bidirectional_iterator_tag, Category>)
+      --it;
+  }
+
+  // Both sides hold the same `It`: comparing iterators which do not come
+  // from the same range is undefined, as for the underlying iterators.
+  auto equal(IAnyIterator<T, Size> const& other) const -> bool override {
+    return it == static_cast<IteratorModel const&>(other).it;
+  }
+};
+
+// Stored by a default-constructed AnyIterator. It only compares equal to
+// another one, as value-initialized forward iterators do; anything else is
+// undefined, so it terminates.
+template <typename T, std::size_t Size>
+struct SingularIterator final : IAnyIterator<T, Size> {
+  void move_to(void* dst) && noexcept override { new (dst) SingularIterator; }
+
+  auto clone() const -> AnyIteratorPoly<T, Size> override {
+    return AnyIteratorPoly<T, Size>{SingularIterator{}};
+  }
+
+  auto dereference() const -> T& override { std::terminate(); }
+
+  void increment() override { std::terminate(); }
+
+  void decrement() override { std::terminate(); }
+
+  auto equal(IAnyIterator<T, Size> const& other) const -> bool override {
+    return other.singular();
+  }
+
+  auto singular() const noexcept -> bool override { return true; }
+};
+
+// Interface implemented by `RangeModel` for each erased iterator type. The
+// range only keeps the part which was not consumed by `next_batch`.
+template <typename T, std::size_t Size> struct IAnyRange {
+  virtual ~IAnyRange() noexcept {}
+  virtual void move_to(void* dst) && noexcept = 0;
+  virtual auto next_batch(T** out, std::size_t count) -> std::size_t = 0;
+  virtual auto empty() const -> bool = 0;
+  virtual auto begin() const -> AnyIteratorPoly<T, Size> = 0;
+  virtual auto end() const -> AnyIteratorPoly<T, Size> = 0;
+};
+
+template <typename It, typename T, std::size_t Size>
+struct RangeModel final : IAnyRange<T, Size> {
+  It first, last;
+
+  RangeModel(It f, It l) noexcept(std::is_nothrow_move_constructible_v<It>)
+      : first(std::move(f)), last(std::move(l)) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) RangeModel(std::move(*this));
+  }
+
+  auto next_batch(T** out, std::size_t count) -> std::size_t override {
+    std::size_t n = 0;
+    for (; n < count && first != last; ++n, ++first)
+      out[n] = &*first;
+    return n;
+  }
+
+  auto empty() const -> bool override { return first == last; }
+
+  auto begin() const -> AnyIteratorPoly<T, Size> override {
+    return AnyIteratorPoly<T, Size>{
+        std::in_place_type_t<IteratorModel<It, T, Size>>{}, first};
+  }
+
+  auto end() const -> AnyIteratorPoly<T, Size> override {
+    return AnyIteratorPoly<T, Size>{
+        std::in_place_type_t<IteratorModel<It, T, Size>>{}, last};
+  }
+};
+
+} // namespace details
+
+/// Type-erased iterator stored inline in `Size` bytes.
+///
+/// The erased iterator lives in a `BoundedPoly`, so no allocation ever happens
+/// and moves go through its mover. `Category` is one of the standard tags up
+/// to `std::bidirectional_iterator_tag`, and the erased iterator must model
+/// it. Comparing two `AnyIterator` erasing different iterator types is
+/// undefined. A default-constructed `AnyIterator` is singular: it can only be
+/// assigned, or compared to another default-constructed one.
+template <typename T, typename Category = std::forward_iterator_tag,
+          std::size_t Size = 4 * sizeof(void*)>
+class AnyIterator {
+  static_assert(std::is_base_of_v<std::input_iterator_tag, Category>);
+  static_assert(!std::is_base_of_v<std::random_access_iterator_tag, Category>,
+                "random access is not supported");
+
+  using Poly = details::AnyIteratorPoly<T, Size>;
+
+  template <typename It>
+  using Model = details::IteratorModel<It, T, Size>;
+
+public:
+  using iterator_category = Category;
+  using value_type = std::remove_cv_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  /// CONSTRUCTORS
+
+  AnyIterator() noexcept
+      : poly_{std::in_place_type_t<details::SingularIterator<T, Size>>{}} {}
+
+  template <typename It, typename = std::enable_if_t<
+                             !std::is_same_v<std::decay_t<It>, AnyIterator>>>
+  AnyIterator(It it) : poly_{std::in_place_type_t<Model<It>>{}, std::move(it)} {
+    using ItCategory = typename std::iterator_traits<It>::iterator_category;
+    static_assert(std::is_base_of_v<Category, ItCategory>,
+                  "the iterator does not model Category");
+    static_assert(std::is_convertible_v<decltype(*it), T&>);
+  }
+
+  /// Used by `AnyRange`, which already built the erased iterator.
+  explicit AnyIterator(Poly&& poly) noexcept : poly_{std::move(poly)} {}
+
+  AnyIterator(AnyIterator const& other) : poly_{other.poly_->clone()} {}
+
+  AnyIterator(AnyIterator&&) noexcept = default;
+
+  /// ASSIGNMENT OPERATORS
+
+  auto operator=(AnyIterator const& other) -> AnyIterator& {
+    poly_ = other.poly_->clone();
+    return *this;
+  }
+
+  auto operator=(AnyIterator&&) noexcept -> AnyIterator& = default;
+
+  /// DEREFERENCE OPERATORS
+
+  auto operator*() const -> T& { return poly_->dereference(); }
+
+  auto operator->() const -> T* { return &poly_->dereference(); }
+
+  /// INCREMENT AND DECREMENT OPERATORS
+
+  auto operator++() -> AnyIterator& {
+    poly_->increment();
+    return *this;
+  }
+
+  auto operator++(int) -> AnyIterator {
+    AnyIterator copy = *this;
+    poly_->increment();
+    return copy;
+  }
+
+  auto operator--() -> AnyIterator& {
+    static_assert(
+        std::is_base_of_v<std::bidirectional_iterator_tag, Category>);
+    poly_->decrement();
+    return *this;
+  }
+
+  auto operator--(int) -> AnyIterator {
+    AnyIterator copy = *this;
+    --*this;
+    return copy;
+  }
+
+  /// COMPARISON OPERATORS
+
+  friend auto operator==(AnyIterator const& lhs, AnyIterator const& rhs)
+      -> bool {
+    return lhs.poly_->equal(*rhs.poly_);
+  }
+
+  friend auto operator!=(AnyIterator const& lhs, AnyIterator const& rhs)
+      -> bool {
+    return !(lhs == rhs);
+  }
+
+private:
+  Poly poly_;
+};
+
+/// Type-erased range of `T&`, holding its iterators inline in `Size` bytes.
+///
+/// Besides `begin()` and `end()`, the range can be consumed by batches with
+/// `next_batch`, which costs one virtual call per batch instead of three per
+/// element (compare, dereference, increment).
+template <typename T, std::size_t Size = 8 * sizeof(void*)> class AnyRange {
+  using Poly = BoundedPolyVM<std::aligned_storage_t<Size>,
+                             details::IAnyRange<T, Size>,
+                             &details::IAnyRange<T, Size>::move_to>;
+
+  template <typename It>
+  using Model = details::RangeModel<It, T, Size>;
+
+public:
+  using iterator = AnyIterator<T, std::input_iterator_tag, Size>;
+
+  /// CONSTRUCTORS
+
+  /// Erases `[first, last)`.
+  template <typename It>
+  AnyRange(It first, It last)
+      : poly_{std::in_place_type_t<Model<It>>{}, std::move(first),
+              std::move(last)} {
+    static_assert(std::is_lvalue_reference_v<decltype(*first)>,
+                  "next_batch needs addressable elements");
+  }
+
+  /// Erases `[std::begin(range), std::end(range))`. `range` must outlive this.
+  template <typename Range, typename = std::enable_if_t<
+                                !std::is_same_v<std::decay_t<Range>, AnyRange>>>
+  AnyRange(Range& range) : AnyRange(std::begin(range), std::end(range)) {}
+
+  /// next_batch
+
+  /// Stores the addresses of the next (at most `count`) elements in `out`,
+  /// removes them from the range, and returns how many were stored.
+  auto next_batch(T** out, std::size_t count) -> std::size_t {
+    return poly_->next_batch(out, count);
+  }
+
+  /// for_each
+
+  /// Consumes the range by batches of `BatchSize`, calling `f(T&)` on each
+  /// element.
+  template <std::size_t BatchSize = 64, typename F> void for_each(F&& f) {
+    T* batch[BatchSize];
+    while (std::size_t n = next_batch(batch, BatchSize))
+      for (std::size_t i = 0; i < n; ++i)
+        f(*batch[i]);
+  }
+
+  /// empty
+
+  auto empty() const -> bool { return poly_->empty(); }
+
+  /// ITERATORS
+
+  auto begin() const -> iterator { return iterator{poly_->begin()}; }
+
+  auto end() const -> iterator { return iterator{poly_->end()}; }
+
+private:
+  Poly poly_;
+};
+
+} // namespace jv
+
+#endif
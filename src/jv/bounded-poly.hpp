@@ -7,6 +7,7 @@
 #ifndef JVERNAY_UTILS_BOUNDED_POLY_HPP
 #define JVERNAY_UTILS_BOUNDED_POLY_HPP
 
+#include <cstddef>
 #include <new>
 #include <type_traits>
 #include <utility>
@@ -74,6 +75,90 @@ template <typename Mover> struct impl_MoverStorage<Mover, true> {
 template <typename Mover>
 using MoverStorage = impl_MoverStorage<Mover, std::is_empty_v<Mover>>;
 
+// Whether Mover knows the size of the type it moves.
+template <typename Mover, typename = void>
+struct has_size : std::false_type {};
+
+template <typename Mover>
+struct has_size<Mover, std::void_t<decltype(std::declval<Mover const &>()
+                                                .size())>> : std::true_type {};
+
+// One table per type moved by a UniversalMover: storing a pointer to it
+// costs as much as storing the function pointer alone.
+template <typename T> struct UniversalMoverEntry {
+  void (*move)(T &&src, void *dst) noexcept;
+  void (*relocate_n)(T *src, void *dst, std::size_t n,
+                     std::size_t stride) noexcept;
+  void (*destroy_n)(T *first, std::size_t n, std::size_t stride) noexcept;
+  std::size_t size;
+};
+
+template <typename T, typename A>
+void universal_move(T &&src, void *dst) noexcept {
+  A &&moveref = static_cast<A &&>(src);
+  new (dst) A(std::move(moveref));
+}
+
+// The values are `stride` bytes apart. A is known, so the moves and the
+// destructions are direct calls.
+template <typename T, typename A>
+void universal_relocate_n(T *src, void *dst, std::size_t n,
+                          std::size_t stride) noexcept {
+  auto *from = reinterpret_cast<char *>(src);
+  auto *to = static_cast<char *>(dst);
+  for (; n != 0; --n, from += stride, to += stride) {
+    A &value = static_cast<A &>(*reinterpret_cast<T *>(from));
+    new (to) A(std::move(value));
+    value.A::~A();
+  }
+}
+
+template <typename T, typename A>
+void universal_destroy_n(T *first, std::size_t n, std::size_t stride) noexcept {
+  auto *at = reinterpret_cast<char *>(first);
+  for (; n != 0; --n, at += stride)
+    static_cast<A &>(*reinterpret_cast<T *>(at)).A::~A();
+}
+
+template <typename T, typename A>
+inline constexpr UniversalMoverEntry<T> universal_mover_entry{
+    &universal_move<T, A>, &universal_relocate_n<T, A>,
+    &universal_destroy_n<T, A>, sizeof(A)};
+
+// Whether Mover can relocate and destroy runs of values of a same type,
+// with one indirect call per run, as UniversalMover does.
+template <typename Mover, typename T, typename = void>
+struct moves_runs : std::false_type {};
+
+template <typename Mover, typename T>
+struct moves_runs<
+    Mover, T,
+    std::void_t<decltype(std::declval<Mover const &>() ==
+                         std::declval<Mover const &>()),
+                decltype(std::declval<Mover const &>().relocate_n(
+                    std::declval<T *>(), std::declval<void *>(),
+                    std::size_t{}, std::size_t{})),
+                decltype(std::declval<Mover const &>().destroy_n(
+                    std::declval<T *>(), std::size_t{}, std::size_t{}))>>
+    : std::true_type {};
+
+// Whether Mover must be told each type stored, as VtableMover does.
+template <typename Mover, typename T, typename = void>
+struct registers_types : std::false_type {};
+
+template <typename Mover, typename T>
+struct registers_types<Mover, T,
+                       std::void_t<decltype(Mover::template register_type<T>(
+                           std::declval<T const &>()))>> : std::true_type {};
+
+// The user-defined header, stored before the value. It is an empty base
+// class if there is no header.
+template <typename Header> struct HeaderStorage {
+  Header header_{};
+};
+
+template <> struct HeaderStorage<void> {};
+
 } // namespace details
 
 // A stateful mover which supports every derived type of T.
@@ -81,18 +166,36 @@ template <typename T> class UniversalMover {
 public:
   template <typename A>
   constexpr UniversalMover(A const *) noexcept
-      : mover_{[](T &&src, void *dst) noexcept {
-          A &&moveref = static_cast<A &&>(src);
-          new (dst) A(std::move(moveref));
-        }} {}
+      : entry_{&details::universal_mover_entry<T, A>} {}
 
   constexpr void operator()(T &&src, void *dst) const noexcept {
-    mover_(std::move(src), dst);
+    entry_->move(std::move(src), dst);
+  }
+
+  /// Size of the moved type, `sizeof(A)`.
+  constexpr auto size() const noexcept -> std::size_t { return entry_->size; }
+
+  /// Relocates `n` values of the moved type, `stride` bytes apart, from
+  /// `src` to `dst`: one indirect call for all of them.
+  void relocate_n(T *src, void *dst, std::size_t n,
+                  std::size_t stride) const noexcept {
+    entry_->relocate_n(src, dst, n, stride);
+  }
+
+  /// Destroys `n` values of the moved type, `stride` bytes apart.
+  void destroy_n(T *first, std::size_t n, std::size_t stride) const noexcept {
+    entry_->destroy_n(first, n, stride);
+  }
+
+  /// Whether both move the same type.
+  friend constexpr auto operator==(UniversalMover const &lhs,
+                                   UniversalMover const &rhs) noexcept
+      -> bool {
+    return lhs.entry_ == rhs.entry_;
   }
 
 private:
-  using AbstractMover = void (*)(T &&src, void *dst) noexcept;
-  AbstractMover mover_;
+  details::UniversalMoverEntry<T> const *entry_;
 };
 
 // A stateless mover which calls a polymorphic method of T.
@@ -105,11 +208,22 @@ public:
 };
 
 /// Type abstractor for polymorphic types.
+///
+/// If `Header` is not `void`, a `Header` is stored before the value, and can
+/// be read with `header()` without touching the value nor its vtable: it is
+/// meant for small keys used to filter or sort, such as a priority.
 template <typename Storage, typename Base,
-          typename Mover = UniversalMover<Base>>
-class BoundedPoly : details::MoverStorage<Mover> {
+          typename Mover = UniversalMover<Base>, typename Header = void>
+class BoundedPoly : details::MoverStorage<Mover>,
+                    details::HeaderStorage<Header> {
   using MoverStorage = details::MoverStorage<Mover>;
+  using HeaderStorage = details::HeaderStorage<Header>;
+  // Type of the header parameters, not deduced. Those members are disabled
+  // if Header is void.
+  using HeaderArg =
+      std::conditional_t<std::is_void_v<Header>, HeaderStorage, Header>;
 
+  static_assert(std::is_void_v<Header> || std::is_trivially_copyable_v<Header>);
   static_assert(std::is_nothrow_destructible_v<Base>);
   static_assert(std::has_virtual_destructor_v<Base>);
   static_assert(is_storable_v<Base, Storage>);
@@ -134,6 +248,7 @@ public:
       : MoverStorage{static_cast<Derived const *>(nullptr)} {
     static_assert(can_handle_v<Derived>);
     new (&storage_) Derived(std::forward<Derived>(derived));
+    register_stored<Derived>();
   }
 
   template <typename Derived, typename... Args>
@@ -142,12 +257,36 @@ public:
     static_assert(std::is_constructible_v<Derived, Args...>);
     static_assert(can_handle_v<Derived>);
     new (&storage_) Derived(std::forward<Args>(args)...);
+    register_stored<Derived>();
+  }
+
+  template <typename Derived, typename H = Header,
+            typename = std::enable_if_t<!std::is_void_v<H>>>
+  BoundedPoly(HeaderArg const &header, Derived &&derived)
+      : MoverStorage{static_cast<std::decay_t<Derived> const *>(nullptr)},
+        HeaderStorage{header} {
+    static_assert(can_handle_v<std::decay_t<Derived>>);
+    new (&storage_) std::decay_t<Derived>(std::forward<Derived>(derived));
+    register_stored<Derived>();
+  }
+
+  template <typename Derived, typename... Args, typename H = Header,
+            typename = std::enable_if_t<!std::is_void_v<H>>>
+  BoundedPoly(HeaderArg const &header, std::in_place_type_t<Derived>,
+              Args &&... args)
+      : MoverStorage{static_cast<Derived const *>(nullptr)},
+        HeaderStorage{header} {
+    static_assert(std::is_constructible_v<Derived, Args...>);
+    static_assert(can_handle_v<Derived>);
+    new (&storage_) Derived(std::forward<Args>(args)...);
+    register_stored<Derived>();
   }
 
   BoundedPoly(BoundedPoly const &) = delete;
 
   BoundedPoly(BoundedPoly &&other) noexcept
-      : MoverStorage{(MoverStorage const &)other} {
+      : MoverStorage{(MoverStorage const &)other},
+        HeaderStorage{(HeaderStorage const &)other} {
     this->mover_(std::move(other.get()), &storage_);
   }
 
@@ -162,6 +301,7 @@ public:
     get().~Base(); // erase the current stored value
     this->copy_mover(mover.mover_);
     new (&storage_) Derived(std::move(derived));
+    register_stored<Derived>();
     return *this;
   }
 
@@ -169,6 +309,7 @@ public:
 
   auto operator=(BoundedPoly &&other) noexcept -> BoundedPoly & {
     get().~Base();
+    static_cast<HeaderStorage &>(*this) = other;
     this->copy_mover(other.mover_);
     this->mover_(std::move(other.get()), &storage_);
     return *this;
@@ -176,6 +317,7 @@ public:
 
   /// emplace
 
+  /// Replaces the stored value. The header is kept.
   template <typename Derived, typename... Args>
   void emplace(Args &&... args) noexcept {
     static_assert(can_handle_v<Derived>);
@@ -184,12 +326,66 @@ public:
     get().~Base();
     this->copy_mover(mover.mover_);
     new (&storage_) Derived(std::forward<Args>(args)...);
+    register_stored<Derived>();
+  }
+
+  /// Replaces the stored value and the header.
+  template <typename Derived, typename... Args, typename H = Header,
+            typename = std::enable_if_t<!std::is_void_v<H>>>
+  void emplace_with_header(HeaderArg const &header,
+                           Args &&... args) noexcept {
+    emplace<Derived>(std::forward<Args>(args)...);
+    this->header_ = header;
+  }
+
+  /// emplace_recycled
+
+  /// Replaces the stored value by a `Derived` from `recycler`, a `Recycler`:
+  /// the stored value itself if it is a `Derived`, or else a free one, reset
+  /// with `args...`, or else a new `Derived(args...)`. The replaced value is
+  /// relocated into `recycler`. The header is kept.
+  template <typename Derived, typename Recycler, typename... Args>
+  void emplace_recycled(Recycler &recycler, Args &&... args) {
+    static_assert(can_handle_v<Derived>);
+    if (recycler.template reset_stored<Derived>(get(), args...))
+      return;
+    // the strong guarantee: what may throw comes before the replacement
+    Derived *free = recycler.template reset_free<Derived>(args...);
+    MoverStorage mover{static_cast<Derived const *>(nullptr)}; // may throw
+    if (free != nullptr) {
+      // not a Derived: it goes to another list than free
+      recycler.retire(get());
+      recycler.template pop_free<Derived>(&storage_);
+    } else if constexpr (std::is_nothrow_constructible_v<Derived, Args...>) {
+      recycler.retire(get());
+      new (&storage_) Derived(std::forward<Args>(args)...);
+    } else {
+      Derived value(std::forward<Args>(args)...);
+      recycler.retire(get());
+      new (&storage_) Derived(std::move(value));
+    }
+    this->copy_mover(mover.mover_);
+    register_stored<Derived>();
   }
 
   /// DESTRUCTOR
 
   ~BoundedPoly() noexcept { get().~Base(); }
 
+  /// header
+
+  template <typename H = Header,
+            typename = std::enable_if_t<!std::is_void_v<H>>>
+  auto header() noexcept -> H & {
+    return this->header_;
+  }
+
+  template <typename H = Header,
+            typename = std::enable_if_t<!std::is_void_v<H>>>
+  auto header() const noexcept -> H const & {
+    return this->header_;
+  }
+
   /// get
 
   auto get() noexcept -> Base & { return reinterpret_cast<Base &>(storage_); }
@@ -198,6 +394,25 @@ public:
     return reinterpret_cast<Base const &>(storage_);
   }
 
+  /// as
+
+  /// The stored value as an `Interface`, or `nullptr` if it does not
+  /// implement it. `Mover` must know the interfaces, see `InterfaceMover`.
+  template <typename Interface> auto as() noexcept -> Interface * {
+    if constexpr (std::is_same_v<Interface, Base>)
+      return &get();
+    else
+      return this->mover_.template cast<Interface>(&get());
+  }
+
+  template <typename Interface> auto as() const noexcept -> Interface const * {
+    if constexpr (std::is_same_v<Interface, Base>)
+      return &get();
+    else
+      return this->mover_.template cast<Interface const>(
+          const_cast<Base *>(&get()));
+  }
+
   /// DEREFERENCE OPERATORS
 
   auto operator*() noexcept -> Base & {
@@ -216,24 +431,104 @@ public:
     return reinterpret_cast<Base const *>(&storage_);
   }
 
+  /// stored_size
+
+  /// Size of the stored value, if `Mover` knows it (see `UniversalMover`),
+  /// else `sizeof(Storage)`.
+  auto stored_size() const noexcept -> std::size_t {
+    if constexpr (details::has_size<Mover>::value)
+      return this->mover_.size();
+    else
+      return sizeof(Storage);
+  }
+
+  /// live_size
+
+  /// Number of bytes of this object actually in use: the mover, the header
+  /// and the stored value. The rest of `Storage` holds nothing, so relocating
+  /// the `BoundedPoly` with `memcpy` only needs to copy this prefix.
+  auto live_size() const noexcept -> std::size_t {
+    auto const offset = reinterpret_cast<char const *>(&storage_) -
+                        reinterpret_cast<char const *>(this);
+    return static_cast<std::size_t>(offset) + stored_size();
+  }
+
+  /// RUNS
+
+  /// With a `Mover` moving runs of values of a same type, such as
+  /// `UniversalMover`, `uninitialized_relocate` and `destroy` make one
+  /// indirect call per run of elements storing the same type, instead of one
+  /// or two per element.
+
+  /// Number of elements from `first`, up to `last`, storing the same type.
+  template <typename M = Mover,
+            typename = std::enable_if_t<details::moves_runs<M, Base>::value>>
+  static auto run_length(BoundedPoly const *first,
+                         BoundedPoly const *last) noexcept -> std::size_t {
+    BoundedPoly const *end = first + 1;
+    while (end != last && end->mover_ == first->mover_)
+      ++end;
+    return static_cast<std::size_t>(end - first);
+  }
+
+  /// Relocates the run `[first, first + n)` to the uninitialized
+  /// `[dest, dest + n)`, which must not overlap it.
+  template <typename M = Mover,
+            typename = std::enable_if_t<details::moves_runs<M, Base>::value>>
+  static void relocate_run(BoundedPoly *first, std::size_t n,
+                           BoundedPoly *dest) noexcept {
+    for (std::size_t i = 0; i < n; ++i)
+      new (dest + i) BoundedPoly(first[i], Shell{});
+    first->mover_.relocate_n(&first->get(), &dest->storage_, n,
+                             sizeof(BoundedPoly));
+  }
+
+  /// Destroys the run `[first, first + n)`.
+  template <typename M = Mover,
+            typename = std::enable_if_t<details::moves_runs<M, Base>::value>>
+  static void destroy_run(BoundedPoly *first, std::size_t n) noexcept {
+    static_assert(std::is_trivially_destructible_v<M>); // nothing else to do
+    first->mover_.destroy_n(&first->get(), n, sizeof(BoundedPoly));
+  }
+
   /// swap
 
   void swap(BoundedPoly &other) noexcept {
+    // each value is relocated: moved, then its source is destroyed. Moves
+    // only touch the bytes of the stored values, so the untouched part of
+    // tmp costs nothing.
     Storage tmp;
     this->mover_(std::move(get()), &tmp);
+    get().~Base();
     other.mover_(std::move(other.get()), &storage_);
+    other.get().~Base();
     this->mover_(std::move(reinterpret_cast<Base &>(tmp)), &other.storage_);
     reinterpret_cast<Base &>(tmp).~Base();
     this->swap_mover(other);
+    std::swap(static_cast<HeaderStorage &>(*this),
+              static_cast<HeaderStorage &>(other));
   }
 
 private:
+  struct Shell {};
+
+  // Copies the mover and the header only: the value is relocated apart.
+  BoundedPoly(BoundedPoly const &other, Shell) noexcept
+      : MoverStorage{(MoverStorage const &)other},
+        HeaderStorage{(HeaderStorage const &)other} {}
+
+  template <typename Derived> void register_stored() {
+    if constexpr (details::registers_types<Mover, Base>::value)
+      Mover::template register_type<std::decay_t<Derived>>(get());
+  }
+
   Storage storage_;
 };
 
 template <typename Storage, typename Base,
-          void (Base::*Method)(void *dst) &&noexcept>
-using BoundedPolyVM = BoundedPoly<Storage, Base, VirtualMover<Base, Method>>;
+          void (Base::*Method)(void *dst) &&noexcept, typename Header = void>
+using BoundedPolyVM =
+    BoundedPoly<Storage, Base, VirtualMover<Base, Method>, Header>;
 
 } // namespace jv
 
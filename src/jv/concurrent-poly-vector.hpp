@@ -0,0 +1,236 @@
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_CONCURRENT_POLY_VECTOR_HPP
+#define JVERNAY_UTILS_CONCURRENT_POLY_VECTOR_HPP
+
+#include <jv/prefetch.hpp>
+#include <jv/uninitialized.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+/// Append-only vector supporting concurrent producers and readers.
+///
+/// Producers reserve a slot with a single `fetch_add`, construct the value in
+/// place without holding any lock, then publish it. Readers only see the
+/// published prefix `[0, size())`, in index order, and elements never move.
+/// `Poly` is typically a `BoundedPoly`, but any nothrow move constructible type
+/// works.
+template <typename Poly, std::size_t ChunkSize = 1024>
+class ConcurrentPolyVector {
+  static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0,
+                "ChunkSize must be a power of two");
+  static_assert(std::is_nothrow_destructible_v<Poly>);
+
+  // Chunk `k` holds `ChunkSize << k` slots, so the directory never needs to be
+  // reallocated: 48 chunks are far more than any address space can hold.
+  static constexpr std::size_t DirectorySize = 48;
+
+  struct Chunk {
+    using Slot = std::aligned_storage_t<sizeof(Poly), alignof(Poly)>;
+    Slot* slots;
+    std::atomic<bool>* ready;
+  };
+
+public:
+  using value_type = Poly;
+  using size_type = std::size_t;
+
+  /// CONSTRUCTORS
+
+  ConcurrentPolyVector() noexcept {
+    for (auto& chunk : directory_)
+      chunk.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ConcurrentPolyVector(ConcurrentPolyVector const&) = delete;
+  auto operator=(ConcurrentPolyVector const&)
+      -> ConcurrentPolyVector& = delete;
+
+  /// DESTRUCTOR
+
+  /// Must not run concurrently with any other operation: every producer must
+  /// have returned from `emplace_back`.
+  ~ConcurrentPolyVector() noexcept {
+    std::size_t const size = published_.load(std::memory_order_acquire);
+    for (std::size_t k = 0; chunk_begin(k) < size; ++k) {
+      Chunk* chunk = directory_[k].load(std::memory_order_relaxed);
+      auto* first = reinterpret_cast<Poly*>(chunk->slots);
+      jv::destroy(first,
+                  first + std::min(chunk_size(k), size - chunk_begin(k)));
+    }
+    for (std::size_t k = 0; k < DirectorySize; ++k)
+      free_chunk(directory_[k].load(std::memory_order_relaxed));
+  }
+
+  /// reserve
+
+  /// Allocates chunks up-front so that producers never allocate while the
+  /// first `n` elements are appended.
+  void reserve(std::size_t n) {
+    if (n == 0)
+      return;
+    std::size_t const last = chunk_of(n - 1);
+    for (std::size_t k = 0; k <= last; ++k)
+      acquire_chunk(k);
+  }
+
+  /// emplace_back
+
+  /// Constructs `Poly(args...)` in a freshly reserved slot and returns its
+  /// index. The slot is reserved before the value is built, so construction
+  /// must not fail: an exception (including `std::bad_alloc` when a new chunk
+  /// is needed) terminates the program.
+  template <typename... Args>
+  auto emplace_back(Args&&... args) noexcept -> std::size_t {
+    std::size_t const index = reserved_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t const k = chunk_of(index);
+    std::size_t const offset = index - chunk_begin(k);
+    Chunk* chunk = acquire_chunk(k);
+    new (&chunk->slots[offset]) Poly(std::forward<Args>(args)...);
+    chunk->ready[offset].store(true, std::memory_order_seq_cst);
+    publish();
+    return index;
+  }
+
+  /// push_back
+
+  template <typename T> auto push_back(T&& value) noexcept -> std::size_t {
+    return emplace_back(std::forward<T>(value));
+  }
+
+  /// size
+
+  /// Number of published elements. Every index below it can be read.
+  auto size() const noexcept -> std::size_t {
+    return published_.load(std::memory_order_acquire);
+  }
+
+  auto empty() const noexcept -> bool { return size() == 0; }
+
+  /// ELEMENT ACCESS
+
+  /// `index` must be lower than a value previously returned by `size()`.
+  auto operator[](std::size_t index) noexcept -> Poly& {
+    std::size_t const k = chunk_of(index);
+    Chunk* chunk = directory_[k].load(std::memory_order_acquire);
+    return reinterpret_cast<Poly&>(chunk->slots[index - chunk_begin(k)]);
+  }
+
+  auto operator[](std::size_t index) const noexcept -> Poly const& {
+    return const_cast<ConcurrentPolyVector&>(*this)[index];
+  }
+
+  /// for_each
+
+  /// Calls `f` on every element published when the call starts, in order,
+  /// walking chunk by chunk to avoid recomputing the chunk of each index.
+  /// A non-zero `prefetch_distance` prefetches elements ahead, as done by
+  /// `jv::for_each_prefetch`, which pays off for large elements.
+  template <typename F>
+  void for_each(F&& f, std::size_t prefetch_distance = 0) {
+    std::size_t const size = this->size();
+    for (std::size_t k = 0; chunk_begin(k) < size; ++k) {
+      Chunk* chunk = directory_[k].load(std::memory_order_acquire);
+      std::size_t const count = std::min(chunk_size(k), size - chunk_begin(k));
+      auto* first = reinterpret_cast<Poly*>(chunk->slots);
+      struct {
+        Poly* first;
+        Poly* last;
+        auto begin() const noexcept { return first; }
+        auto end() const noexcept { return last; }
+      } const slots{first, first + count};
+      for_each_prefetch(slots, f, prefetch_distance);
+    }
+  }
+
+  template <typename F>
+  void for_each(F&& f, std::size_t prefetch_distance = 0) const {
+    const_cast<ConcurrentPolyVector&>(*this).for_each(
+        [&](Poly const& poly) { f(poly); }, prefetch_distance);
+  }
+
+private:
+  static constexpr auto chunk_size(std::size_t k) noexcept -> std::size_t {
+    return ChunkSize << k;
+  }
+
+  static constexpr auto chunk_begin(std::size_t k) noexcept -> std::size_t {
+    return ChunkSize * ((std::size_t{1} << k) - 1);
+  }
+
+  static constexpr auto chunk_of(std::size_t index) noexcept -> std::size_t {
+    std::size_t n = index / ChunkSize + 1, k = 0;
+    while (n >>= 1)
+      ++k;
+    return k;
+  }
+
+  auto acquire_chunk(std::size_t k) -> Chunk* {
+    Chunk* chunk = directory_[k].load(std::memory_order_acquire);
+    if (chunk != nullptr)
+      return chunk;
+    Chunk* fresh = allocate_chunk(k);
+    if (directory_[k].compare_exchange_strong(chunk, fresh,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+      return fresh;
+    free_chunk(fresh); // another producer installed it first
+    return chunk;
+  }
+
+  static auto allocate_chunk(std::size_t k) -> Chunk* {
+    std::size_t const n = chunk_size(k);
+    auto* chunk = new Chunk;
+    chunk->slots = new typename Chunk::Slot[n];
+    chunk->ready = new std::atomic<bool>[n];
+    for (std::size_t i = 0; i < n; ++i)
+      chunk->ready[i].store(false, std::memory_order_relaxed);
+    return chunk;
+  }
+
+  static void free_chunk(Chunk* chunk) noexcept {
+    if (chunk == nullptr)
+      return;
+    delete[] chunk->ready;
+    delete[] chunk->slots;
+    delete chunk;
+  }
+
+  auto is_ready(std::size_t index) const noexcept -> bool {
+    std::size_t const k = chunk_of(index);
+    Chunk* chunk = directory_[k].load(std::memory_order_acquire);
+    return chunk != nullptr &&
+           chunk->ready[index - chunk_begin(k)].load(std::memory_order_seq_cst);
+  }
+
+  // Advances `published_` over every contiguous ready slot. Whichever producer
+  // observes the gap being filled last moves the counter past its own slot, so
+  // readers always see elements appear in index order.
+  void publish() noexcept {
+    std::size_t published = published_.load(std::memory_order_seq_cst);
+    while (is_ready(published)) {
+      // on failure, `published` is reloaded and we retry from there
+      if (published_.compare_exchange_weak(published, published + 1,
+                                           std::memory_order_seq_cst))
+        ++published;
+    }
+  }
+
+  std::atomic<Chunk*> directory_[DirectorySize];
+  alignas(64) std::atomic<std::size_t> reserved_{0};
+  alignas(64) std::atomic<std::size_t> published_{0};
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,202 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_COW_POLY_VECTOR_HPP
+#define JVERNAY_UTILS_COW_POLY_VECTOR_HPP
+
+#include <jv/uninitialized.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+/// Vector of `Poly` whose copies are cheap snapshots.
+///
+/// Elements live in reference-counted chunks of `ChunkSize` slots, shared by
+/// every version which did not modify them. Copying the vector copies the
+/// list of chunks, and the first modification of a shared chunk copies that
+/// chunk only (path copying), through the `clone` function given at
+/// construction, which is never called otherwise. `Poly` itself may be
+/// move-only, as `BoundedPoly` is.
+///
+/// Different versions can be used from different threads, as chunks are
+/// never modified while shared. A given version, and copying it, are not
+/// thread-safe.
+template <typename Poly, std::size_t ChunkSize = 64> class CowPolyVector {
+  static_assert(ChunkSize > 0);
+  static_assert(std::is_nothrow_destructible_v<Poly>);
+
+  struct Chunk {
+    using Slot = std::aligned_storage_t<sizeof(Poly), alignof(Poly)>;
+    std::atomic<std::size_t> refs{1};
+    std::size_t size = 0;
+    Slot slots[ChunkSize];
+
+    auto operator[](std::size_t i) noexcept -> Poly& {
+      return reinterpret_cast<Poly&>(slots[i]);
+    }
+
+    ~Chunk() noexcept {
+      auto* first = reinterpret_cast<Poly*>(slots);
+      jv::destroy(first, first + size);
+    }
+  };
+
+public:
+  using value_type = Poly;
+  using size_type = std::size_t;
+  using Clone = Poly (*)(Poly const&);
+
+  /// CONSTRUCTORS
+
+  explicit CowPolyVector(Clone clone) noexcept : clone_{clone} {}
+
+  /// Snapshot: O(number of chunks).
+  CowPolyVector(CowPolyVector const& other)
+      : chunks_{other.chunks_}, size_{other.size_}, clone_{other.clone_} {
+    for (Chunk* chunk : chunks_)
+      chunk->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  CowPolyVector(CowPolyVector&& other) noexcept
+      : chunks_{std::move(other.chunks_)},
+        size_{std::exchange(other.size_, 0)}, clone_{other.clone_} {
+    other.chunks_.clear();
+  }
+
+  auto operator=(CowPolyVector other) noexcept -> CowPolyVector& {
+    swap(other);
+    return *this;
+  }
+
+  /// DESTRUCTOR
+
+  ~CowPolyVector() noexcept {
+    for (Chunk* chunk : chunks_)
+      release(chunk);
+  }
+
+  /// swap
+
+  void swap(CowPolyVector& other) noexcept {
+    chunks_.swap(other.chunks_);
+    std::swap(size_, other.size_);
+    std::swap(clone_, other.clone_);
+  }
+
+  /// snapshot
+
+  auto snapshot() const -> CowPolyVector { return *this; }
+
+  /// emplace_back
+
+  template <typename Derived, typename... Args>
+  auto emplace_back(Args&&... args) -> Poly& {
+    return push_back(Poly{std::in_place_type_t<Derived>{},
+                          std::forward<Args>(args)...});
+  }
+
+  /// push_back
+
+  auto push_back(Poly poly) -> Poly& {
+    std::size_t const offset = size_ % ChunkSize;
+    if (offset == 0) {
+      chunks_.reserve(chunks_.size() + 1);
+      chunks_.push_back(new Chunk);
+    } else {
+      unshare(chunks_.size() - 1);
+    }
+    Chunk& chunk = *chunks_.back();
+    Poly* result = new (&chunk.slots[offset]) Poly(std::move(poly));
+    ++chunk.size;
+    ++size_;
+    return *result;
+  }
+
+  /// pop_back
+
+  void pop_back() {
+    std::size_t const offset = (size_ - 1) % ChunkSize;
+    if (offset == 0) {
+      release(chunks_.back());
+      chunks_.pop_back();
+    } else {
+      unshare(chunks_.size() - 1);
+      Chunk& chunk = *chunks_.back();
+      chunk[offset].~Poly();
+      --chunk.size;
+    }
+    --size_;
+  }
+
+  /// mutate
+
+  /// Mutable access to an element, copying its chunk first if it is shared.
+  auto mutate(std::size_t index) -> Poly& {
+    unshare(index / ChunkSize);
+    return (*chunks_[index / ChunkSize])[index % ChunkSize];
+  }
+
+  /// ELEMENT ACCESS
+
+  auto operator[](std::size_t index) const noexcept -> Poly const& {
+    return (*chunks_[index / ChunkSize])[index % ChunkSize];
+  }
+
+  auto size() const noexcept -> std::size_t { return size_; }
+
+  auto empty() const noexcept -> bool { return size_ == 0; }
+
+  /// Calls `f` on every element, in order, chunk by chunk.
+  template <typename F> void for_each(F&& f) const {
+    for (Chunk* chunk : chunks_)
+      for (std::size_t i = 0; i < chunk->size; ++i)
+        f(static_cast<Poly const&>((*chunk)[i]));
+  }
+
+  /// Whether the chunk holding `index` is shared with another version.
+  auto is_shared(std::size_t index) const noexcept -> bool {
+    return chunks_[index / ChunkSize]->refs.load(std::memory_order_acquire) >
+           1;
+  }
+
+private:
+  static void release(Chunk* chunk) noexcept {
+    if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      delete chunk;
+  }
+
+  // Gives this version its own copy of chunk `k`. The acquire load pairs
+  // with the release of the other versions, so their reads are done.
+  void unshare(std::size_t k) {
+    Chunk* shared = chunks_[k];
+    if (shared->refs.load(std::memory_order_acquire) == 1)
+      return;
+    Chunk* copy = new Chunk;
+    try {
+      for (; copy->size < shared->size; ++copy->size)
+        new (&copy->slots[copy->size]) Poly(clone_((*shared)[copy->size]));
+    } catch (...) {
+      delete copy;
+      throw;
+    }
+    chunks_[k] = copy;
+    release(shared);
+  }
+
+  std::vector<Chunk*> chunks_;
+  std::size_t size_ = 0;
+  Clone clone_;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,322 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_DATAFLOW_GRAPH_HPP
+#define JVERNAY_UTILS_DATAFLOW_GRAPH_HPP
+
+#include <jv/bounded-poly.hpp>
+#include <jv/thread-pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+/// Values of the parents of a node, in the order they were given.
+template <typename T> class DataflowInputs {
+public:
+  DataflowInputs(T const* values, std::uint32_t const* indices,
+                 std::size_t count) noexcept
+      : values_{values}, indices_{indices}, count_{count} {}
+
+  auto size() const noexcept -> std::size_t { return count_; }
+
+  auto operator[](std::size_t i) const noexcept -> T const& {
+    return values_[indices_[i]];
+  }
+
+private:
+  T const* values_;
+  std::uint32_t const* indices_;
+  std::size_t count_;
+};
+
+/// Interface of an operator of `DataflowGraph`. `compute` must not modify
+/// anything but the operator itself, as independent operators may run
+/// concurrently.
+template <typename T> struct IDataflowNode {
+  virtual ~IDataflowNode() noexcept {}
+  virtual void move_to(void* dst) && noexcept = 0;
+  virtual auto compute(DataflowInputs<T> const& inputs) -> T = 0;
+};
+
+namespace dataflow {
+
+/// Node whose value is set from outside the graph.
+template <typename T> struct Source final : IDataflowNode<T> {
+  void move_to(void* dst) && noexcept override {
+    new (dst) Source(std::move(*this));
+  }
+  auto compute(DataflowInputs<T> const&) -> T override { return T{}; }
+};
+
+/// Node applying `F` to the values of its parents.
+template <typename T, typename F, std::size_t Arity>
+struct Function final : IDataflowNode<T> {
+  F f;
+
+  Function(F fn) noexcept(std::is_nothrow_move_constructible_v<F>)
+      : f(std::move(fn)) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) Function(std::move(*this));
+  }
+
+  auto compute(DataflowInputs<T> const& inputs) -> T override {
+    return call(inputs, std::make_index_sequence<Arity>{});
+  }
+
+private:
+  template <std::size_t... I>
+  auto call(DataflowInputs<T> const& inputs, std::index_sequence<I...>) -> T {
+    return f(inputs[I]...);
+  }
+};
+
+} // namespace dataflow
+
+namespace details {
+
+template <typename T>
+using equality_result_t =
+    decltype(std::declval<T const&>() == std::declval<T const&>());
+
+template <typename T, typename = void>
+struct is_equality_comparable : std::false_type {};
+
+template <typename T>
+struct is_equality_comparable<T, std::void_t<equality_result_t<T>>>
+    : std::true_type {};
+
+} // namespace details
+
+/// Incremental DAG of heterogeneous operators producing values of type `T`.
+///
+/// Operators are `BoundedPoly` objects stored contiguously, sorted by level
+/// (the length of the longest path from a source), which is a topological
+/// order. Changing a source marks its children dirty; `recompute` walks the
+/// levels in order and only runs dirty operators, whose children become dirty
+/// in turn if the value changed. Dirty operators of a level are independent,
+/// so they may run in parallel on a `ThreadPool`.
+template <typename T, std::size_t NodeSize = 32> class DataflowGraph {
+public:
+  using Node = BoundedPolyVM<std::aligned_storage_t<NodeSize>,
+                             IDataflowNode<T>, &IDataflowNode<T>::move_to>;
+  using NodeId = std::uint32_t;
+
+  /// Collects the operators. Parents must be added before their children,
+  /// which makes cycles impossible.
+  class Builder {
+  public:
+    auto source(T value) -> NodeId {
+      NodeId id = add<dataflow::Source<T>>({});
+      initial_values_.back() = std::move(value);
+      is_source_.back() = true;
+      return id;
+    }
+
+    /// Adds a node applying `f` to the given parents.
+    template <typename F, typename... Ids>
+    auto function(F f, Ids... parents) -> NodeId {
+      return add<dataflow::Function<T, F, sizeof...(Ids)>>(
+          {static_cast<NodeId>(parents)...}, std::move(f));
+    }
+
+    /// Adds a user-defined operator, constructed from `args`.
+    template <typename Derived, typename... Args>
+    auto add(std::vector<NodeId> const& parents, Args&&... args) -> NodeId {
+      for (NodeId parent : parents)
+        if (parent >= nodes_.size())
+          throw std::invalid_argument{"jv::DataflowGraph: unknown parent"};
+      nodes_.emplace_back(std::in_place_type_t<Derived>{},
+                          std::forward<Args>(args)...);
+      parents_.push_back(parents);
+      initial_values_.emplace_back();
+      is_source_.push_back(false);
+      return static_cast<NodeId>(nodes_.size() - 1);
+    }
+
+    auto build() && -> DataflowGraph { return DataflowGraph{std::move(*this)}; }
+
+  private:
+    friend class DataflowGraph;
+
+    std::vector<Node> nodes_;
+    std::vector<std::vector<NodeId>> parents_;
+    std::vector<T> initial_values_;
+    std::vector<bool> is_source_;
+  };
+
+  /// set
+
+  /// Changes the value of a source, marking its children dirty.
+  void set(NodeId source, T value) {
+    std::uint32_t const position = position_[source];
+    if constexpr (details::is_equality_comparable<T>::value)
+      if (values_[position] == value)
+        return;
+    values_[position] = std::move(value);
+    mark_children(position);
+  }
+
+  /// value
+
+  /// Last computed value of a node.
+  auto value(NodeId id) const noexcept -> T const& {
+    return values_[position_[id]];
+  }
+
+  /// recompute
+
+  /// Recomputes the dirty operators, level by level. Operators without
+  /// parents, other than sources, only run on the first call. Levels with at
+  /// least `parallel_threshold` dirty operators are split across `pool`.
+  /// Returns how many operators ran.
+  auto recompute(ThreadPool* pool = nullptr,
+                 std::size_t parallel_threshold = 64) -> std::size_t {
+    std::size_t computed = 0;
+    for (std::size_t level = 0; level + 1 < level_begin_.size(); ++level) {
+      std::uint32_t* dirty = dirty_list_.get() + level_begin_[level];
+      std::size_t const count =
+          dirty_count_[level].exchange(0, std::memory_order_acq_rel);
+      if (count == 0)
+        continue;
+      std::sort(dirty, dirty + count); // visit memory in order
+      auto run = [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+          compute(dirty[i]);
+      };
+      if (pool != nullptr && count >= parallel_threshold)
+        pool->parallel_for(0, count, 16, run);
+      else
+        run(0, count);
+      computed += count;
+    }
+    return computed;
+  }
+
+  /// size
+
+  auto size() const noexcept -> std::size_t { return nodes_.size(); }
+
+private:
+  explicit DataflowGraph(Builder&& builder) {
+    std::size_t const n = builder.nodes_.size();
+
+    // levels, computed in creation order since parents come first
+    std::vector<std::uint32_t> level(n, 0);
+    for (std::size_t id = 0; id < n; ++id)
+      for (NodeId parent : builder.parents_[id])
+        level[id] = std::max(level[id], level[parent] + 1);
+    std::uint32_t const nb_levels =
+        n == 0 ? 0 : *std::max_element(level.begin(), level.end()) + 1;
+
+    // stable counting sort by level
+    level_begin_.assign(nb_levels + 1, 0);
+    for (std::size_t id = 0; id < n; ++id)
+      ++level_begin_[level[id] + 1];
+    for (std::size_t l = 0; l < nb_levels; ++l)
+      level_begin_[l + 1] += level_begin_[l];
+    std::vector<std::uint32_t> fill(level_begin_.begin(), level_begin_.end());
+    position_.resize(n);
+    for (std::size_t id = 0; id < n; ++id)
+      position_[id] = fill[level[id]]++;
+
+    std::vector<NodeId> order(n);
+    for (std::size_t id = 0; id < n; ++id)
+      order[position_[id]] = static_cast<NodeId>(id);
+
+    nodes_.reserve(n);
+    values_.reset(new T[n]);
+    level_of_.resize(n);
+    parent_begin_.push_back(0);
+    std::vector<std::vector<std::uint32_t>> children(n);
+    for (std::uint32_t position = 0; position < n; ++position) {
+      NodeId const id = order[position];
+      nodes_.push_back(std::move(builder.nodes_[id]));
+      values_[position] = std::move(builder.initial_values_[id]);
+      level_of_[position] = level[id];
+      for (NodeId parent : builder.parents_[id]) {
+        parents_.push_back(position_[parent]);
+        children[position_[parent]].push_back(position);
+      }
+      parent_begin_.push_back(static_cast<std::uint32_t>(parents_.size()));
+    }
+    child_begin_.push_back(0);
+    for (auto const& list : children) {
+      children_.insert(children_.end(), list.begin(), list.end());
+      child_begin_.push_back(static_cast<std::uint32_t>(children_.size()));
+    }
+
+    dirty_.reset(new std::atomic<bool>[n]);
+    dirty_list_.reset(new std::uint32_t[n]);
+    dirty_count_.reset(new std::atomic<std::size_t>[nb_levels]);
+    for (std::size_t l = 0; l < nb_levels; ++l)
+      dirty_count_[l].store(0, std::memory_order_relaxed);
+    // sources are never computed; everything else starts dirty
+    for (std::uint32_t position = 0; position < n; ++position) {
+      dirty_[position].store(false, std::memory_order_relaxed);
+      if (!builder.is_source_[order[position]])
+        mark(position);
+    }
+  }
+
+  void compute(std::uint32_t position) {
+    dirty_[position].store(false, std::memory_order_relaxed);
+    DataflowInputs<T> inputs{values_.get(),
+                             parents_.data() + parent_begin_[position],
+                             parent_begin_[position + 1] -
+                                 parent_begin_[position]};
+    T result = nodes_[position]->compute(inputs);
+    if constexpr (details::is_equality_comparable<T>::value)
+      if (result == values_[position])
+        return; // nothing downstream needs to change
+    values_[position] = std::move(result);
+    mark_children(position);
+  }
+
+  void mark_children(std::uint32_t position) {
+    for (std::uint32_t c = child_begin_[position];
+         c < child_begin_[position + 1]; ++c)
+      mark(children_[c]);
+  }
+
+  // Adds the node to the dirty list of its level, once. Parents of a node may
+  // run concurrently, hence the atomics.
+  void mark(std::uint32_t position) {
+    if (dirty_[position].exchange(true, std::memory_order_acq_rel))
+      return;
+    std::uint32_t const level = level_of_[position];
+    std::size_t const slot =
+        dirty_count_[level].fetch_add(1, std::memory_order_acq_rel);
+    dirty_list_[level_begin_[level] + slot] = position;
+  }
+
+  std::vector<Node> nodes_; // sorted by level
+  // not a std::vector, which would pack bools, and make the writes of
+  // concurrent operators race
+  std::unique_ptr<T[]> values_;
+  std::vector<std::uint32_t> position_; // NodeId -> position
+  std::vector<std::uint32_t> level_of_;
+  std::vector<std::uint32_t> level_begin_;
+  std::vector<std::uint32_t> parent_begin_, parents_;
+  std::vector<std::uint32_t> child_begin_, children_;
+
+  std::unique_ptr<std::atomic<bool>[]> dirty_;
+  std::unique_ptr<std::uint32_t[]> dirty_list_; // partitioned by level
+  std::unique_ptr<std::atomic<std::size_t>[]> dirty_count_;
+};
+
+} // namespace jv
+
+#endif
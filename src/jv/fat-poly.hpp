@@ -0,0 +1,195 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_FAT_POLY_HPP
+#define JVERNAY_UTILS_FAT_POLY_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+// Signature of the cached function of a method, taking `this` explicitly.
+template <typename Self, typename R, typename... Args> struct method_signature {
+  using self_type = Self;
+  using result_type = R;
+  using function_type = R (*)(Self*, Args...);
+
+  // Fallback resolution: a call on the concrete type.
+  template <typename Derived, auto Method>
+  static auto thunk(Self* self, Args... args) -> R {
+    using Qualified = std::conditional_t<std::is_const_v<Self>,
+                                         Derived const, Derived>;
+    return (static_cast<Qualified*>(self)->*Method)(
+        std::forward<Args>(args)...);
+  }
+};
+
+template <typename M> struct method_traits;
+
+template <typename C, typename R, typename... Args>
+struct method_traits<R (C::*)(Args...)> : method_signature<C, R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct method_traits<R (C::*)(Args...) const>
+    : method_signature<C const, R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct method_traits<R (C::*)(Args...) noexcept>
+    : method_signature<C, R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct method_traits<R (C::*)(Args...) const noexcept>
+    : method_signature<C const, R, Args...> {};
+
+template <auto Method>
+using method_function_t =
+    typename method_traits<decltype(Method)>::function_type;
+
+// Pointers to virtual methods cannot be compared in constant expressions,
+// but they can be compared as template arguments.
+template <auto Method> struct method_tag {};
+
+template <auto Method, auto... Methods>
+constexpr auto method_index() noexcept -> std::size_t {
+  constexpr bool found[] = {
+      std::is_same_v<method_tag<Method>, method_tag<Methods>>...};
+  for (std::size_t i = 0; i < sizeof...(Methods); ++i)
+    if (found[i])
+      return i;
+  return sizeof...(Methods);
+}
+
+// Function cached for `Method` when `value` is a `Derived`. Compilers do not
+// devirtualize calls through a member pointer, even on a final type, so GCC
+// reads the final override from the vtable of `value` (its "bound member
+// function" extension), which is then called directly. Elsewhere, the thunk
+// makes a virtual call.
+template <typename Derived, auto Method, typename Base>
+auto resolve_method(Base& value) noexcept -> method_function_t<Method> {
+  using Traits = method_traits<decltype(Method)>;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Wpmf-conversions"
+  using Self = typename Traits::self_type;
+  return reinterpret_cast<typename Traits::function_type>(
+      static_cast<Self&>(value).*Method);
+#pragma GCC diagnostic pop
+#else
+  (void)value;
+  return &Traits::template thunk<Derived, Method>;
+#endif
+}
+
+} // namespace details
+
+/// `BoundedPoly` which caches, in each element, the function called by each
+/// of `Methods` for the stored type.
+///
+/// `call<&Base::method>(args...)` loads this function and calls it: one load
+/// and an indirect call, instead of loading the vtable, then the function in
+/// the vtable. Stored types must be final: on GCC, the cached function is
+/// then the final override itself, read from the vtable of the value when it
+/// is constructed. Other compilers cache a function making the virtual call.
+/// It pays off in tight loops over few hot methods, at the cost of one
+/// pointer per method in each element.
+template <typename Storage, typename Base, auto... Methods> class FatPoly {
+  using Poly = BoundedPoly<Storage, Base>;
+  using Cache = std::tuple<details::method_function_t<Methods>...>;
+
+public:
+  /// method_index
+
+  template <auto Method>
+  static constexpr std::size_t method_index_v =
+      details::method_index<Method, Methods...>();
+
+  /// CONSTRUCTORS
+
+  template <typename Derived,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<Derived>, FatPoly>>>
+  FatPoly(Derived&& derived)
+      : cache_{}, poly_{std::forward<Derived>(derived)} {
+    cache_ = resolve<std::decay_t<Derived>>();
+  }
+
+  template <typename Derived, typename... Args>
+  FatPoly(std::in_place_type_t<Derived> tag, Args&&... args)
+      : cache_{}, poly_{tag, std::forward<Args>(args)...} {
+    cache_ = resolve<Derived>();
+  }
+
+  FatPoly(FatPoly&&) noexcept = default;
+
+  /// ASSIGNMENT OPERATORS
+
+  auto operator=(FatPoly&&) noexcept -> FatPoly& = default;
+
+  /// emplace
+
+  template <typename Derived, typename... Args>
+  void emplace(Args&&... args) noexcept {
+    poly_.template emplace<Derived>(std::forward<Args>(args)...);
+    cache_ = resolve<Derived>();
+  }
+
+  /// call
+
+  /// Calls `Method`, which must be one of `Methods`, on the stored value.
+  template <auto Method, typename... Args>
+  decltype(auto) call(Args&&... args) {
+    return std::get<method_index_v<Method>>(cache_)(
+        &poly_.get(), std::forward<Args>(args)...);
+  }
+
+  template <auto Method, typename... Args>
+  decltype(auto) call(Args&&... args) const {
+    return std::get<method_index_v<Method>>(cache_)(
+        &poly_.get(), std::forward<Args>(args)...);
+  }
+
+  /// get
+
+  auto get() noexcept -> Base& { return poly_.get(); }
+  auto get() const noexcept -> Base const& { return poly_.get(); }
+
+  /// DEREFERENCE OPERATORS
+
+  auto operator*() noexcept -> Base& { return poly_.get(); }
+  auto operator*() const noexcept -> Base const& { return poly_.get(); }
+  auto operator->() noexcept -> Base* { return &poly_.get(); }
+  auto operator->() const noexcept -> Base const* { return &poly_.get(); }
+
+  /// swap
+
+  void swap(FatPoly& other) noexcept {
+    std::swap(cache_, other.cache_);
+    poly_.swap(other.poly_);
+  }
+
+private:
+  // From the constructed value, whose vtable is read on GCC.
+  template <typename Derived> auto resolve() noexcept -> Cache {
+    static_assert(std::is_final_v<Derived>,
+                  "cached calls are only direct on final types");
+    return Cache{details::resolve_method<Derived, Methods>(poly_.get())...};
+  }
+
+  Cache cache_;
+  Poly poly_;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,402 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_FLAT_EXPR_TREE_HPP
+#define JVERNAY_UTILS_FLAT_EXPR_TREE_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+/// Interface of a node of `FlatExprTree`.
+///
+/// A node receives the values of its children in `args`: one value each in
+/// `eval`, one block of `count` rows each in `eval_batch`. Variables read the
+/// input row (or input columns) directly.
+template <typename T> struct IExprNode {
+  virtual ~IExprNode() noexcept {}
+  virtual void move_to(void* dst) && noexcept = 0;
+
+  virtual auto arity() const noexcept -> std::uint32_t = 0;
+
+  /// A pure node, whose value only depends on its children, is folded at
+  /// build time when its children are all constants. Nodes are not pure
+  /// unless they say so.
+  virtual auto is_pure() const noexcept -> bool { return false; }
+
+  /// Returns `true` and sets `value` if the node is a constant.
+  virtual auto as_constant(T& /* value */) const noexcept -> bool {
+    return false;
+  }
+
+  virtual auto eval(T const* args, T const* row) const -> T = 0;
+
+  virtual void eval_batch(T const* const* args, T const* const* columns,
+                          std::size_t first_row, std::size_t count,
+                          T* out) const = 0;
+};
+
+namespace expr {
+
+template <typename T> struct Constant final : IExprNode<T> {
+  T value;
+
+  Constant(T v) noexcept : value(v) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) Constant(std::move(*this));
+  }
+
+  auto arity() const noexcept -> std::uint32_t override { return 0; }
+
+  auto is_pure() const noexcept -> bool override { return true; }
+
+  auto as_constant(T& v) const noexcept -> bool override {
+    v = value;
+    return true;
+  }
+
+  auto eval(T const*, T const*) const -> T override { return value; }
+
+  void eval_batch(T const* const*, T const* const*, std::size_t,
+                  std::size_t count, T* out) const override {
+    std::fill(out, out + count, value);
+  }
+};
+
+template <typename T> struct Variable final : IExprNode<T> {
+  std::uint32_t column;
+
+  Variable(std::uint32_t c) noexcept : column(c) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) Variable(std::move(*this));
+  }
+
+  auto arity() const noexcept -> std::uint32_t override { return 0; }
+
+  auto eval(T const*, T const* row) const -> T override { return row[column]; }
+
+  void eval_batch(T const* const*, T const* const* columns,
+                  std::size_t first_row, std::size_t count,
+                  T* out) const override {
+    std::copy(columns[column] + first_row, columns[column] + first_row + count,
+              out);
+  }
+};
+
+/// Whether calling `F` only depends on its arguments. True for the
+/// arithmetic function objects of `<functional>`; specialize it for others.
+template <typename F> struct is_pure_function : std::false_type {};
+
+template <typename U> struct is_pure_function<std::plus<U>> : std::true_type {};
+template <typename U>
+struct is_pure_function<std::minus<U>> : std::true_type {};
+template <typename U>
+struct is_pure_function<std::multiplies<U>> : std::true_type {};
+template <typename U>
+struct is_pure_function<std::divides<U>> : std::true_type {};
+template <typename U>
+struct is_pure_function<std::modulus<U>> : std::true_type {};
+template <typename U>
+struct is_pure_function<std::negate<U>> : std::true_type {};
+
+/// Node applying `F` to its `Arity` children. `eval_batch` is a plain loop
+/// over the rows calling `F` directly, so the compiler can vectorize it.
+/// It is pure if `Pure` is.
+template <typename T, typename F, std::size_t Arity,
+          bool Pure = is_pure_function<F>::value>
+struct Function final : IExprNode<T> {
+  F f;
+
+  Function(F fn) noexcept(std::is_nothrow_move_constructible_v<F>)
+      : f(std::move(fn)) {}
+
+  void move_to(void* dst) && noexcept override {
+    new (dst) Function(std::move(*this));
+  }
+
+  auto arity() const noexcept -> std::uint32_t override { return Arity; }
+
+  auto is_pure() const noexcept -> bool override { return Pure; }
+
+  auto eval(T const* args, T const*) const -> T override {
+    return call(args, std::make_index_sequence<Arity>{});
+  }
+
+  void eval_batch(T const* const* args, T const* const*, std::size_t,
+                  std::size_t count, T* out) const override {
+    batch(args, count, out, std::make_index_sequence<Arity>{});
+  }
+
+private:
+  template <std::size_t... I>
+  auto call(T const* args, std::index_sequence<I...>) const -> T {
+    return f(args[I]...);
+  }
+
+  template <std::size_t... I>
+  void batch(T const* const* args, std::size_t count, T* out,
+             std::index_sequence<I...>) const {
+    T const* const columns[] = {args[I]..., nullptr};
+    for (std::size_t row = 0; row < count; ++row)
+      out[row] = f(columns[I][row]...);
+  }
+};
+
+} // namespace expr
+
+/// Reference to a node being built by `FlatExprTree::Builder`.
+struct ExprRef {
+  std::uint32_t index;
+};
+
+/// Expression tree stored as a flat array of `BoundedPoly` nodes.
+///
+/// Nodes are stored in post-order, each node knowing its children by 32-bit
+/// indices, so evaluation is a single forward pass over contiguous memory
+/// with a stack of intermediate values. `evaluate_batch` runs each node over a
+/// block of `BlockSize` rows at once, paying one virtual call per node and
+/// block instead of per row.
+template <typename T = double, std::size_t NodeSize = 32,
+          std::size_t BlockSize = 128>
+class FlatExprTree {
+public:
+  using Node = BoundedPolyVM<std::aligned_storage_t<NodeSize>, IExprNode<T>,
+                             &IExprNode<T>::move_to>;
+
+  /// Builds a tree bottom-up. Each node may only be used once as a child.
+  class Builder {
+  public:
+    auto constant(T value) -> ExprRef {
+      return add<expr::Constant<T>>({}, value);
+    }
+
+    auto variable(std::uint32_t column) -> ExprRef {
+      return add<expr::Variable<T>>({}, column);
+    }
+
+    /// Adds a node applying `f` to the given children. It is only folded if
+    /// `expr::is_pure_function<F>` is true.
+    template <typename F, typename... Refs>
+    auto function(F f, Refs... children) -> ExprRef {
+      static_assert((std::is_same_v<Refs, ExprRef> && ...));
+      return add<expr::Function<T, F, sizeof...(Refs)>>({children...},
+                                                        std::move(f));
+    }
+
+    /// Same as `function`, for an `f` whose result only depends on its
+    /// arguments, so that it can be folded.
+    template <typename F, typename... Refs>
+    auto pure_function(F f, Refs... children) -> ExprRef {
+      static_assert((std::is_same_v<Refs, ExprRef> && ...));
+      return add<expr::Function<T, F, sizeof...(Refs), true>>({children...},
+                                                              std::move(f));
+    }
+
+    /// Adds a user-defined node, constructed from `args`.
+    template <typename Derived, typename... Args>
+    auto add(std::vector<ExprRef> const& children, Args&&... args) -> ExprRef {
+      for (ExprRef child : children) {
+        if (child.index >= nodes_.size() || used_[child.index])
+          throw std::invalid_argument{
+              "jv::FlatExprTree: a node can only have one parent"};
+      }
+      nodes_.emplace_back(std::in_place_type_t<Derived>{},
+                          std::forward<Args>(args)...);
+      if (nodes_.back()->arity() != children.size()) {
+        nodes_.pop_back();
+        throw std::invalid_argument{"jv::FlatExprTree: wrong arity"};
+      }
+      for (ExprRef child : children) {
+        used_[child.index] = true;
+        children_.push_back(child.index);
+      }
+      first_child_.push_back(
+          static_cast<std::uint32_t>(children_.size() - children.size()));
+      used_.push_back(false);
+      return ExprRef{static_cast<std::uint32_t>(nodes_.size() - 1)};
+    }
+
+    /// Emits the nodes reachable from `root` in post-order, folding pure
+    /// subtrees whose leaves are constants.
+    auto build(ExprRef root) && -> FlatExprTree {
+      FlatExprTree tree;
+      tree.nodes_.reserve(nodes_.size());
+      // depth-first, with an explicit stack so that deep trees cannot
+      // overflow the call stack
+      std::vector<Frame> frames{Frame{root.index, 0, 0, true}};
+      std::vector<std::uint32_t> emitted; // positions of the emitted children
+      while (!frames.empty()) {
+        Frame& frame = frames.back();
+        if (frame.next_child < nodes_[frame.index]->arity()) {
+          std::uint32_t const child =
+              children_[first_child_[frame.index] + frame.next_child];
+          frames.push_back(Frame{child, 0, 0, true});
+          continue;
+        }
+        Frame const done = frame;
+        frames.pop_back();
+        std::uint32_t const depth = emit(tree, done, emitted);
+        if (!frames.empty()) {
+          Frame& parent = frames.back();
+          parent.depth = std::max(parent.depth, parent.next_child + depth);
+          T value;
+          parent.all_constants = parent.all_constants &&
+                                 tree.nodes_.back()->as_constant(value);
+          ++parent.next_child;
+        }
+      }
+      tree.max_depth_ = std::max<std::uint32_t>(tree.max_depth_, 1);
+      return tree;
+    }
+
+  private:
+    // A node whose children are being emitted.
+    struct Frame {
+      std::uint32_t index;
+      std::uint32_t next_child;
+      std::uint32_t depth; // of the evaluation stack, for the children so far
+      bool all_constants;
+    };
+
+    // Appends the node of `frame` to `tree`, once its children are the last
+    // `arity` positions of `emitted`, which are replaced by its own. Returns
+    // the depth of the evaluation stack its subtree needs.
+    auto emit(FlatExprTree& tree, Frame const& frame,
+              std::vector<std::uint32_t>& emitted) -> std::uint32_t {
+      Node& node = nodes_[frame.index];
+      std::uint32_t const arity = node->arity();
+      std::uint32_t const* const children =
+          emitted.data() + emitted.size() - arity;
+      std::uint32_t const depth = std::max<std::uint32_t>(frame.depth, 1);
+      tree.max_depth_ = std::max(tree.max_depth_, depth);
+
+      if (arity > 0 && frame.all_constants && node->is_pure()) {
+        // children are the last emitted nodes: replace them by their value
+        std::vector<T> args(arity);
+        for (std::uint32_t i = 0; i < arity; ++i)
+          tree.nodes_[children[i]]->as_constant(args[i]);
+        T const value = node->eval(args.data(), nullptr);
+        while (tree.nodes_.size() > children[0]) {
+          tree.nodes_.pop_back();
+          tree.links_.pop_back();
+        }
+        tree.nodes_.emplace_back(std::in_place_type_t<expr::Constant<T>>{},
+                                 value);
+        tree.links_.push_back({0, 0});
+      } else {
+        tree.nodes_.push_back(std::move(node));
+        auto const first = static_cast<std::uint32_t>(tree.children_.size());
+        tree.children_.insert(tree.children_.end(), children,
+                              children + arity);
+        tree.links_.push_back({first, arity});
+      }
+      emitted.resize(emitted.size() - arity);
+      emitted.push_back(static_cast<std::uint32_t>(tree.nodes_.size() - 1));
+      return depth;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<std::uint32_t> children_;
+    std::vector<std::uint32_t> first_child_;
+    std::vector<bool> used_;
+  };
+
+  /// size
+
+  /// Number of nodes after folding.
+  auto size() const noexcept -> std::size_t { return nodes_.size(); }
+
+  /// node
+
+  auto node(std::size_t index) const noexcept -> Node const& {
+    return nodes_[index];
+  }
+
+  /// children
+
+  /// Indices of the children of the node at `index`, as `[first, last)`.
+  auto children(std::size_t index) const noexcept
+      -> std::pair<std::uint32_t const*, std::uint32_t const*> {
+    std::uint32_t const* first = children_.data() + links_[index].first_child;
+    return {first, first + links_[index].arity};
+  }
+
+  /// evaluate
+
+  /// Evaluates the tree on one row of inputs, indexed by variable column.
+  auto evaluate(T const* row) const -> T {
+    T local[64];
+    std::vector<T> heap;
+    T* stack = local;
+    if (max_depth_ > 64) {
+      heap.resize(max_depth_);
+      stack = heap.data();
+    }
+    std::size_t top = 0;
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+      // children are the `arity` values on top of the stack
+      top -= links_[i].arity;
+      stack[top] = nodes_[i]->eval(stack + top, row);
+      ++top;
+    }
+    return stack[0];
+  }
+
+  /// evaluate_batch
+
+  /// Evaluates the tree on `nb_rows` rows, reading variable `k` of row `r` at
+  /// `columns[k][r]`, and writes the results to `out`.
+  void evaluate_batch(T const* const* columns, std::size_t nb_rows,
+                      T* out) const {
+    std::vector<T> stack(max_depth_ * BlockSize);
+    std::vector<T const*> args;
+    for (std::size_t first = 0; first < nb_rows; first += BlockSize) {
+      std::size_t const count = std::min(BlockSize, nb_rows - first);
+      std::size_t top = 0;
+      for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        std::uint32_t const arity = links_[i].arity;
+        top -= arity;
+        args.resize(arity);
+        for (std::uint32_t a = 0; a < arity; ++a)
+          args[a] = stack.data() + (top + a) * BlockSize;
+        // the result overwrites the block of the first child, which is fine
+        // since each row only reads its own values
+        nodes_[i]->eval_batch(args.data(), columns, first, count,
+                              stack.data() + top * BlockSize);
+        ++top;
+      }
+      std::copy(stack.begin(), stack.begin() + count, out + first);
+    }
+  }
+
+private:
+  FlatExprTree() = default;
+
+  struct Links {
+    std::uint32_t first_child;
+    std::uint32_t arity;
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<Links> links_;
+  std::vector<std::uint32_t> children_;
+  std::uint32_t max_depth_ = 0;
+};
+
+} // namespace jv
+
+#endif
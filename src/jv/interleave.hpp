@@ -0,0 +1,188 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_INTERLEAVE_HPP
+#define JVERNAY_UTILS_INTERLEAVE_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+// Applies f to the elements of the pipelines [first, last), K pipelines at
+// a time in lockstep: the K calls of a row do not depend on each other, so
+// the CPU overlaps their loads and indirect calls.
+template <std::size_t K, typename Pipelines, typename States, typename F>
+void interleave_pipelines(Pipelines const& pipelines, States& states, F& f,
+                          std::size_t first, std::size_t last) {
+  using std::begin;
+  using std::size;
+  using Iterator = decltype(begin(*begin(pipelines)));
+  auto const pipes = begin(pipelines);
+  auto const state = begin(states);
+
+  std::size_t p = first;
+  for (; p + K <= last; p += K) {
+    std::array<Iterator, K> its;
+    std::array<std::size_t, K> sizes;
+    std::size_t common = ~std::size_t{0};
+    for (std::size_t j = 0; j < K; ++j) {
+      its[j] = begin(pipes[p + j]);
+      sizes[j] = size(pipes[p + j]);
+      common = std::min(common, sizes[j]);
+    }
+    for (std::size_t i = 0; i < common; ++i)
+      for (std::size_t j = 0; j < K; ++j) // unrolled, K is a constant
+        f(its[j][i], state[p + j]);
+    for (std::size_t j = 0; j < K; ++j) // the longer pipelines
+      for (std::size_t i = common; i < sizes[j]; ++i)
+        f(its[j][i], state[p + j]);
+  }
+  if constexpr (K > 1) // the last (last - first) % K
+    interleave_pipelines<1>(pipelines, states, f, p, last);
+}
+
+// Interleaving factors tried by the tuning, dispatched to constants.
+constexpr std::size_t InterleaveFactors[] = {1, 2, 4, 8};
+
+template <typename Pipelines, typename States, typename F>
+void interleave_pipelines(std::size_t k, Pipelines const& pipelines,
+                          States& states, F& f, std::size_t first,
+                          std::size_t last) {
+  switch (k) {
+  case 1: interleave_pipelines<1>(pipelines, states, f, first, last); break;
+  case 2: interleave_pipelines<2>(pipelines, states, f, first, last); break;
+  case 4: interleave_pipelines<4>(pipelines, states, f, first, last); break;
+  default: interleave_pipelines<8>(pipelines, states, f, first, last);
+  }
+}
+
+// Below this, too few pipelines to measure anything.
+constexpr std::size_t MinTuningPipelines = 16 * 8;
+
+// Evaluates the pipelines with the factor k, tuned first if k == 0. Returns
+// the factor used for the last pipelines.
+template <typename Pipelines, typename States, typename F>
+auto evaluate_interleaved(Pipelines const& pipelines, States& states, F& f,
+                          std::size_t k) -> std::size_t {
+  using std::begin;
+  using std::size;
+  using Clock = std::chrono::steady_clock;
+
+  auto const pipes = begin(pipelines);
+  std::size_t const nb_pipelines = size(pipelines);
+
+  std::size_t first = 0;
+  if (k == 0 && nb_pipelines >= MinTuningPipelines) {
+    std::size_t const slice = nb_pipelines / 16 / 8 * 8;
+    // untimed, so that the first factor timed does not warm the caches and
+    // the branch predictors for the others
+    interleave_pipelines(4, pipelines, states, f, first, slice);
+    first += slice;
+    double best_time = 0;
+    for (std::size_t factor : InterleaveFactors) {
+      auto const start = Clock::now();
+      interleave_pipelines(factor, pipelines, states, f, first, first + slice);
+      std::chrono::duration<double> const elapsed = Clock::now() - start;
+      std::size_t nb_elements = 1;
+      for (std::size_t p = first; p < first + slice; ++p)
+        nb_elements += size(pipes[p]);
+      double const time = elapsed.count() / double(nb_elements);
+      if (k == 0 || time < best_time) {
+        k = factor;
+        best_time = time;
+      }
+      first += slice;
+    }
+  } else if (k == 0) {
+    k = 4;
+  }
+  std::size_t factor = 1;
+  for (std::size_t candidate : InterleaveFactors)
+    if (candidate <= k)
+      factor = candidate;
+
+  interleave_pipelines(factor, pipelines, states, f, first, nb_pipelines);
+  return factor;
+}
+
+} // namespace details
+
+/// Interleaving factor tuned by `evaluate_interleaved`, owned by the caller:
+/// keep one per kind of pipelines, and do not share it between threads.
+///
+/// The factor is tuned again when the number of pipelines is more than twice,
+/// or less than half, the number it was tuned on.
+class InterleaveTuner {
+public:
+  /// The tuned factor, or 0 if not tuned yet.
+  auto factor() const noexcept -> std::size_t { return factor_; }
+
+  /// Number of pipelines the factor was tuned on.
+  auto nb_pipelines() const noexcept -> std::size_t { return nb_pipelines_; }
+
+  /// The factor to use for `nb_pipelines` pipelines, or 0 to tune it.
+  auto factor_for(std::size_t nb_pipelines) const noexcept -> std::size_t {
+    if (nb_pipelines > 2 * nb_pipelines_ || 2 * nb_pipelines < nb_pipelines_)
+      return 0;
+    return factor_;
+  }
+
+  void record(std::size_t factor, std::size_t nb_pipelines) noexcept {
+    factor_ = factor;
+    nb_pipelines_ = nb_pipelines;
+  }
+
+  /// Forgets the factor, so that the next evaluation tunes it.
+  void reset() noexcept { record(0, 0); }
+
+private:
+  std::size_t factor_ = 0;
+  std::size_t nb_pipelines_ = 0;
+};
+
+/// evaluate_interleaved
+
+/// Calls `f(element, states[p])` on each element of each pipeline
+/// `pipelines[p]`, in order within a pipeline, so that independent pipelines
+/// are evaluated together: `k` pipelines are walked in lockstep, one element
+/// of each in turn. Pipelines and states are random-access ranges, with one
+/// state per pipeline, and pipelines may have different lengths.
+///
+/// With `k == 0`, `k` is tuned: after a warm-up, each factor is timed on a
+/// sixteenth of the pipelines, and the fastest evaluates the remaining
+/// pipelines. Other values of `k` are rounded down to 1, 2, 4 or 8. Returns
+/// the `k` used for the last pipelines.
+template <typename Pipelines, typename States, typename F>
+auto evaluate_interleaved(Pipelines const& pipelines, States& states, F&& f,
+                          std::size_t k = 0) -> std::size_t {
+  return details::evaluate_interleaved(pipelines, states, f, k);
+}
+
+/// Same, with the `k` of `tuner`, which is tuned by the first call, and
+/// again when the number of pipelines changes too much.
+template <typename Pipelines, typename States, typename F>
+auto evaluate_interleaved(Pipelines const& pipelines, States& states, F&& f,
+                          InterleaveTuner& tuner) -> std::size_t {
+  using std::size;
+  std::size_t const nb_pipelines = size(pipelines);
+  std::size_t const k = tuner.factor_for(nb_pipelines);
+  std::size_t const used =
+      details::evaluate_interleaved(pipelines, states, f, k);
+  if (k == 0 && nb_pipelines >= details::MinTuningPipelines)
+    tuner.record(used, nb_pipelines);
+  return used;
+}
+
+} // namespace jv
+
+#endif
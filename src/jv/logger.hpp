@@ -0,0 +1,386 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_LOGGER_HPP
+#define JVERNAY_UTILS_LOGGER_HPP
+
+#include <jv/bounded-poly.hpp>
+#include <jv/ring-buffer.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+/// Interface of a captured log line, formatted later by the writer thread.
+struct ILogRecord {
+  virtual ~ILogRecord() noexcept {}
+  virtual void format(std::ostream& out) const = 0;
+};
+
+/// Copy of a C string, truncated to `N - 1` characters. `Logger::log`
+/// captures character arrays as such a copy; pointers to characters must be
+/// wrapped in one, as they may dangle by the time the record is written.
+template <std::size_t N> struct LogString {
+  static_assert(N > 0);
+
+  char chars[N];
+
+  LogString(char const* string) noexcept {
+    std::size_t i = 0;
+    for (; i + 1 < N && string[i] != '\0'; ++i)
+      chars[i] = string[i];
+    chars[i] = '\0';
+  }
+
+  friend auto operator<<(std::ostream& out, LogString const& string)
+      -> std::ostream& {
+    return out << string.chars;
+  }
+};
+
+/// What `Logger::log` does when the ring of the calling thread is full.
+enum class OverflowPolicy {
+  Drop, ///< the record is discarded and counted in `Logger::dropped()`
+  Block ///< the calling thread waits for the writer to make room
+};
+
+namespace details {
+
+// Writes `format` up to the next "{}" placeholder, and returns what follows
+// it. Without placeholder, writes the whole string and returns `nullptr`.
+inline auto write_until_placeholder(std::ostream& out, char const* format)
+    -> char const* {
+  char const* placeholder = std::strstr(format, "{}");
+  if (placeholder == nullptr) {
+    out << format;
+    return nullptr;
+  }
+  out.write(format, placeholder - format);
+  return placeholder + 2;
+}
+
+template <typename Arg>
+auto write_argument(std::ostream& out, char const* format, Arg const& arg)
+    -> char const* {
+  if (format == nullptr)
+    return nullptr; // more arguments than placeholders: extra ones are ignored
+  out << arg;
+  return write_until_placeholder(out, format);
+}
+
+// Type under which a log argument is captured: a copy of character arrays,
+// the decayed type otherwise.
+template <typename T> struct log_capture { using type = std::decay_t<T>; };
+
+template <std::size_t N> struct log_capture<char const (&)[N]> {
+  using type = LogString<N>;
+};
+
+template <std::size_t N> struct log_capture<char (&)[N]> {
+  using type = LogString<N>;
+};
+
+template <typename T> using log_capture_t = typename log_capture<T>::type;
+
+template <typename T>
+constexpr bool is_char_pointer_v =
+    std::is_same_v<std::remove_cv_t<std::remove_reference_t<T>>, char*> ||
+    std::is_same_v<std::remove_cv_t<std::remove_reference_t<T>>, char const*>;
+
+// Rings of the calling thread, flagged when it exits so that their logger
+// reclaims them once drained. Holding the flags keeps the rings alive, even
+// if their logger is destroyed first.
+class ExitFlags {
+public:
+  static auto local() -> ExitFlags& {
+    static thread_local ExitFlags flags;
+    return flags;
+  }
+
+  void add(std::shared_ptr<std::atomic<bool>> flag) {
+    auto const orphan = [](auto const& f) { return f.use_count() == 1; };
+    // the rings of destroyed loggers
+    flags_.erase(std::remove_if(flags_.begin(), flags_.end(), orphan),
+                 flags_.end());
+    flags_.push_back(std::move(flag));
+  }
+
+  ~ExitFlags() noexcept {
+    for (auto const& flag : flags_)
+      flag->store(true, std::memory_order_release);
+  }
+
+private:
+  std::vector<std::shared_ptr<std::atomic<bool>>> flags_;
+};
+
+// Record type generated for each call site: `Site::format()` returns the
+// format string, and the arguments are captured by value.
+template <typename Site, typename... Args> struct LogRecord : ILogRecord {
+  std::tuple<Args...> args;
+
+  template <typename... T>
+  LogRecord(T&&... values) noexcept(
+      std::is_nothrow_constructible_v<std::tuple<Args...>, T&&...>)
+      : args{std::forward<T>(values)...} {}
+
+  void format(std::ostream& out) const override {
+    std::apply(
+        [&out](Args const&... values) {
+          char const* rest = write_until_placeholder(out, Site::format());
+          ((rest = write_argument(out, rest, values)), ...);
+          static_cast<void>(rest); // unused by records without arguments
+        },
+        args);
+  }
+};
+
+inline auto next_logger_id() noexcept -> std::uint64_t {
+  static std::atomic<std::uint64_t> id{0};
+  return ++id;
+}
+
+} // namespace details
+
+/// Logger deferring formatting to a background writer thread.
+///
+/// Each call site captures its arguments into a `LogRecord`, stored as a
+/// `BoundedPoly` of `RecordSize` bytes, in a ring owned by the calling
+/// thread. The writer drains the rings in batches, formats the records into
+/// the output stream, and flushes it once per batch. On the hot path, logging
+/// costs a ring push and never allocates. The ring of a thread is freed once
+/// the thread exits and its records are written, so threads must not log
+/// from the destructors of thread-local objects.
+template <std::size_t RecordSize = 64, std::size_t RingCapacity = 1024>
+class Logger {
+public:
+  using Record = BoundedPoly<std::aligned_storage_t<RecordSize>, ILogRecord>;
+
+private:
+  struct Ring {
+    SpscRing<Record, RingCapacity> records;
+    std::thread::id owner;
+    std::atomic<std::size_t> dropped{0};
+    std::atomic<bool> exited{false}; // set by the owner when it exits
+  };
+
+public:
+  /// CONSTRUCTORS
+
+  /// Starts the writer thread. It wakes up every `poll_interval` to look for
+  /// new records.
+  explicit Logger(std::ostream& out,
+                  OverflowPolicy policy = OverflowPolicy::Drop,
+                  std::chrono::microseconds poll_interval =
+                      std::chrono::microseconds{200})
+      : out_{out}, policy_{policy}, poll_interval_{poll_interval},
+        writer_{[this] { write(); }} {}
+
+  Logger(Logger const&) = delete;
+  auto operator=(Logger const&) -> Logger& = delete;
+
+  /// DESTRUCTOR
+
+  /// Writes every pending record, then stops the writer thread.
+  ~Logger() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      running_ = false;
+    }
+    wakeup_.notify_all();
+    writer_.join();
+  }
+
+  /// log
+
+  /// Captures `args` into a record of type `LogRecord<Site, ...>`. Prefer the
+  /// `JV_LOG` macro, which generates `Site` from a string literal.
+  ///
+  /// Arguments are copied, so they must be trivially copyable: character
+  /// arrays are copied as a `LogString`, and pointers to characters must be
+  /// wrapped in one.
+  template <typename Site, typename... Args>
+  void log(char const* /* format, given by Site */, Args&&... args) noexcept {
+    using R = details::LogRecord<Site, details::log_capture_t<Args>...>;
+    static_assert(!(details::is_char_pointer_v<Args> || ...),
+                  "C strings may dangle: wrap them in a jv::LogString");
+    static_assert(
+        (std::is_trivially_copyable_v<details::log_capture_t<Args>> && ...),
+        "log arguments must be trivially copyable");
+    static_assert(std::is_nothrow_constructible_v<R, Args&&...>);
+    static_assert(Record::template can_handle_v<R>,
+                  "log arguments do not fit in RecordSize");
+    Ring& ring = local_ring();
+    while (!ring.records.try_emplace(std::in_place_type_t<R>{},
+                                     std::forward<Args>(args)...)) {
+      if (policy_ == OverflowPolicy::Drop) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  /// flush
+
+  /// Blocks until every record logged before the call has been written and
+  /// the output stream flushed.
+  void flush() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    std::uint64_t const target = passes_ + 2; // a whole pass after this call
+    flush_target_ = std::max(flush_target_, target);
+    wakeup_.notify_all();
+    flushed_.wait(lock, [&] { return passes_ >= target; });
+  }
+
+  /// dropped
+
+  /// Number of records discarded because of `OverflowPolicy::Drop`.
+  auto dropped() const -> std::size_t {
+    std::lock_guard<std::mutex> lock{mutex_};
+    std::size_t total = dropped_by_exited_;
+    for (auto const& ring : rings_)
+      total += ring->dropped.load(std::memory_order_relaxed);
+    return total;
+  }
+
+  /// nb_rings
+
+  /// Number of rings: one per thread which logged, until it exits and its
+  /// records are written.
+  auto nb_rings() const -> std::size_t {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return rings_.size();
+  }
+
+private:
+  // Ring of the calling thread. A thread-local cache avoids taking the lock
+  // after the first record a thread logs to this logger.
+  auto local_ring() -> Ring& {
+    struct Cache {
+      std::uint64_t logger_id = 0;
+      Ring* ring = nullptr;
+    };
+    static thread_local Cache cache;
+    if (cache.logger_id == id_)
+      return *cache.ring;
+
+    std::lock_guard<std::mutex> lock{mutex_};
+    Ring* ring = nullptr;
+    for (auto& candidate : rings_) // ids of exited threads are reused
+      if (candidate->owner == std::this_thread::get_id() &&
+          !candidate->exited.load(std::memory_order_relaxed))
+        ring = candidate.get();
+    if (ring == nullptr) {
+      auto owned = std::make_shared<Ring>();
+      owned->owner = std::this_thread::get_id();
+      details::ExitFlags::local().add(
+          std::shared_ptr<std::atomic<bool>>{owned, &owned->exited});
+      rings_.push_back(owned);
+      ring = owned.get();
+    }
+    cache = Cache{id_, ring};
+    return *ring;
+  }
+
+  auto drain(std::vector<Ring*> const& rings) -> bool {
+    bool written = false;
+    for (Ring* ring : rings)
+      while (ring->records.try_consume([this](Record& record) {
+        record->format(out_);
+        out_.put('\n');
+      }))
+        written = true;
+    return written;
+  }
+
+  // Frees the rings of exited threads, once drained. Their flag is read
+  // first: the records pushed before the exit are then visible.
+  void reclaim_exited() noexcept {
+    auto const reclaimed = [this](std::shared_ptr<Ring> const& ring) {
+      if (!ring->exited.load(std::memory_order_acquire) ||
+          !ring->records.empty())
+        return false;
+      dropped_by_exited_ += ring->dropped.load(std::memory_order_relaxed);
+      return true;
+    };
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(), reclaimed),
+                 rings_.end());
+  }
+
+  void write() {
+    std::vector<Ring*> rings;
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      bool const running = running_;
+      rings.clear();
+      for (auto& ring : rings_)
+        rings.push_back(ring.get());
+      lock.unlock();
+
+      if (drain(rings))
+        out_.flush();
+
+      lock.lock();
+      reclaim_exited();
+      ++passes_;
+      flushed_.notify_all();
+      if (!running)
+        return;
+      wakeup_.wait_for(lock, poll_interval_, [this] {
+        return !running_ || passes_ < flush_target_;
+      });
+    }
+  }
+
+  std::uint64_t const id_ = details::next_logger_id();
+  std::ostream& out_;
+  OverflowPolicy const policy_;
+  std::chrono::microseconds const poll_interval_;
+
+  mutable std::mutex mutex_; // protects everything below
+  std::vector<std::shared_ptr<Ring>> rings_;
+  std::size_t dropped_by_exited_ = 0;
+  bool running_ = true;
+  std::uint64_t passes_ = 0;
+  std::uint64_t flush_target_ = 0;
+  std::condition_variable wakeup_;
+  std::condition_variable flushed_;
+
+  std::thread writer_; // last member: started once everything is initialized
+};
+
+} // namespace jv
+
+/// Logs a line through `logger`, formatting `format` with the arguments in
+/// place of each "{}" on the writer thread. `format` must be a string literal.
+#define JV_LOG(logger, ...)                                                    \
+  [&] {                                                                        \
+    struct JvLogSite {                                                         \
+      static constexpr auto format() noexcept -> char const* {                 \
+        return JV_LOG_FORMAT_(__VA_ARGS__, unused);                            \
+      }                                                                        \
+    };                                                                         \
+    (logger).template log<JvLogSite>(__VA_ARGS__);                             \
+  }()
+
+#define JV_LOG_FORMAT_(format, ...) format
+
+#endif
@@ -0,0 +1,146 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_MULTI_POLY_HPP
+#define JVERNAY_UTILS_MULTI_POLY_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+// Marks an interface which the stored type does not implement.
+constexpr std::ptrdiff_t NoInterface =
+    std::numeric_limits<std::ptrdiff_t>::min();
+
+template <typename Base, std::size_t N> struct InterfaceEntry {
+  void (*move)(Base&& src, void* dst) noexcept;
+  std::size_t size;
+  // offset of each interface from the Base subobject, measured on the first
+  // value stored, see InterfaceMover::register_type
+  std::array<std::ptrdiff_t, N> offsets;
+};
+
+// Whether I is an accessible, unambiguous, non-virtual base of A: A * converts
+// to I *, and back with a static_cast, which is ill-formed through a virtual
+// base.
+template <typename I, typename A, typename = void>
+struct is_static_base : std::false_type {};
+
+template <typename I, typename A>
+struct is_static_base<I, A,
+                      std::void_t<decltype(static_cast<A*>(
+                          std::declval<I*>()))>>
+    : std::bool_constant<std::is_base_of_v<I, A> &&
+                         std::is_convertible_v<A*, I*>> {};
+
+// Offset of Interface in `value`, a constructed A. Through static bases, it
+// is the same for every A.
+template <typename Base, typename A, typename Interface>
+auto interface_offset(Base const& value) noexcept -> std::ptrdiff_t {
+  if constexpr (std::is_base_of_v<Interface, A>) {
+    static_assert(is_static_base<Interface, A>::value,
+                  "interfaces must be public, unambiguous, non-virtual bases");
+    A const& a = static_cast<A const&>(value);
+    return reinterpret_cast<char const*>(static_cast<Interface const*>(&a)) -
+           reinterpret_cast<char const*>(&value);
+  } else {
+    return NoInterface;
+  }
+}
+
+template <typename Base, typename A, typename... Interfaces>
+auto interface_entry() noexcept
+    -> InterfaceEntry<Base, sizeof...(Interfaces)>& {
+  static_assert(is_static_base<Base, A>::value,
+                "Base must be a public, non-virtual base");
+  static InterfaceEntry<Base, sizeof...(Interfaces)> entry{
+      &universal_move<Base, A>, sizeof(A), {}};
+  return entry;
+}
+
+template <typename I, typename... Is>
+constexpr auto interface_index() noexcept -> std::size_t {
+  constexpr bool found[] = {std::is_same_v<I, Is>...};
+  for (std::size_t i = 0; i < sizeof...(Is); ++i)
+    if (found[i])
+      return i;
+  return sizeof...(Is);
+}
+
+} // namespace details
+
+/// A stateful mover which also knows where each of `Interfaces` is in the
+/// moved type, so `BoundedPoly::as` converts to an interface without
+/// `dynamic_cast`.
+///
+/// Like `UniversalMover`, it points to a table per moved type, which holds
+/// the move function, the size and the offset of each interface. The offsets
+/// are measured on the first value of each type, once `BoundedPoly` has
+/// constructed it and called `register_type`. Interfaces implemented by a
+/// stored type must be public, unambiguous and non-virtual bases of it,
+/// which is checked at compile time, and as for any `BoundedPoly`, `Base`
+/// must be the first base of the stored types.
+template <typename Base, typename... Interfaces> class InterfaceMover {
+  using Entry = details::InterfaceEntry<Base, sizeof...(Interfaces)>;
+
+public:
+  template <typename A>
+  InterfaceMover(A const*) noexcept
+      : entry_{&details::interface_entry<Base, A, Interfaces...>()} {}
+
+  /// Called by `BoundedPoly` each time it stores an `A`: the first time,
+  /// measures the offsets of the interfaces in `value`.
+  template <typename A> static void register_type(Base const& value) noexcept {
+    static bool const measured =
+        (details::interface_entry<Base, A, Interfaces...>().offsets =
+             {details::interface_offset<Base, A, Interfaces>(value)...},
+         true);
+    (void)measured;
+  }
+
+  void operator()(Base&& src, void* dst) const noexcept {
+    entry_->move(std::move(src), dst);
+  }
+
+  /// Size of the moved type, `sizeof(A)`.
+  auto size() const noexcept -> std::size_t { return entry_->size; }
+
+  /// `value` as an `Interface`, or `nullptr` if the moved type does not
+  /// implement it.
+  template <typename Interface>
+  auto cast(Base* value) const noexcept -> Interface* {
+    constexpr std::size_t index =
+        details::interface_index<std::remove_const_t<Interface>,
+                                 Interfaces...>();
+    static_assert(index < sizeof...(Interfaces), "unknown interface");
+    std::ptrdiff_t const offset = entry_->offsets[index];
+    if (offset == details::NoInterface)
+      return nullptr;
+    return reinterpret_cast<Interface*>(reinterpret_cast<char*>(value) +
+                                         offset);
+  }
+
+private:
+  Entry const* entry_;
+};
+
+/// `BoundedPoly` whose values can be converted to any of `Interfaces` with
+/// `as<Interface>()`: a load and an addition.
+template <typename Storage, typename Base, typename... Interfaces>
+using MultiPoly =
+    BoundedPoly<Storage, Base, InterfaceMover<Base, Interfaces...>>;
+
+} // namespace jv
+
+#endif
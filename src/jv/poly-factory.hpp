@@ -0,0 +1,263 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_POLY_FACTORY_HPP
+#define JVERNAY_UTILS_POLY_FACTORY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+namespace details {
+
+// FNV-1a, on 8 bytes at a time: a single pass over the name, mixed later
+// for each use.
+inline auto name_hash(std::string_view name) noexcept -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325ull ^ name.size();
+  std::size_t i = 0;
+  for (; i + 8 <= name.size(); i += 8) {
+    std::uint64_t word;
+    std::memcpy(&word, name.data() + i, 8);
+    hash = (hash ^ word) * 0x100000001b3ull;
+    hash ^= hash >> 29;
+  }
+  for (; i < name.size(); ++i)
+    hash = (hash ^ static_cast<unsigned char>(name[i])) * 0x100000001b3ull;
+  return hash;
+}
+
+// splitmix64 finalizer
+constexpr auto mix_hash(std::uint64_t x) noexcept -> std::uint64_t {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+template <typename Container, typename Construct, typename = void>
+struct has_emplace_back_with : std::false_type {};
+
+template <typename Container, typename Construct>
+struct has_emplace_back_with<
+    Container, Construct,
+    std::void_t<decltype(std::declval<Container&>().emplace_back_with(
+        std::declval<Construct>()))>> : std::true_type {};
+
+template <typename Container, typename = void>
+struct has_reserve : std::false_type {};
+
+template <typename Container>
+struct has_reserve<Container,
+                   std::void_t<decltype(std::declval<Container&>().reserve(
+                       std::size_t{}))>> : std::true_type {};
+
+} // namespace details
+
+/// Builds `Poly` values, typically `BoundedPoly`, from the name of their type
+/// and constructor arguments `Args...`.
+///
+/// Types are registered with `add`, then `freeze` builds a perfect hash of
+/// the names (hash and displace): finding a type costs one hash of the name,
+/// one mix with the seed of its bucket and one comparison, whatever the
+/// number of types.
+template <typename Poly, typename... Args> class PolyFactory {
+public:
+  /// Constructs a `Poly` at `dst`.
+  using Construct = void (*)(void* dst, Args... args);
+
+  /// add
+
+  /// Registers `Derived`, constructed from `Args...`, under `name`.
+  template <typename Derived> void add(std::string_view name) {
+    add(name, [](void* dst, Args... args) {
+      new (dst) Poly{std::in_place_type_t<Derived>{},
+                     std::forward<Args>(args)...};
+    });
+  }
+
+  void add(std::string_view name, Construct construct) {
+    if (frozen())
+      throw std::logic_error{"jv::PolyFactory: already frozen"};
+    for (Entry const& entry : entries_)
+      if (entry.name == name)
+        throw std::invalid_argument{"jv::PolyFactory: duplicate name"};
+    entries_.push_back(Entry{std::string{name}, construct});
+  }
+
+  /// freeze
+
+  /// Builds the perfect hash. No type can be added afterwards.
+  void freeze() {
+    if (frozen())
+      return;
+    std::size_t nb_slots = 1;
+    while (nb_slots < 2 * entries_.size())
+      nb_slots *= 2;
+    while (!try_freeze(nb_slots)) {
+      nb_slots *= 2;
+      if (nb_slots > 64 * (entries_.size() + 1)) // names with equal hashes
+        throw std::runtime_error{"jv::PolyFactory: no perfect hash found"};
+    }
+  }
+
+  auto frozen() const noexcept -> bool { return !slots_.empty(); }
+
+  auto size() const noexcept -> std::size_t { return entries_.size(); }
+
+  /// contains
+
+  auto contains(std::string_view name) const noexcept -> bool {
+    return find(name) != nullptr;
+  }
+
+  /// create_at
+
+  /// Constructs the `Poly` of type `name` at the uninitialized `dst`.
+  template <typename... Ts>
+  void create_at(void* dst, std::string_view name, Ts&&... args) const {
+    Entry const* entry = find(name);
+    if (entry == nullptr)
+      throw std::invalid_argument{"jv::PolyFactory: unknown name"};
+    entry->construct(dst, std::forward<Ts>(args)...);
+  }
+
+  /// create
+
+  template <typename... Ts>
+  auto create(std::string_view name, Ts&&... args) const -> Poly {
+    std::aligned_storage_t<sizeof(Poly), alignof(Poly)> buffer;
+    create_at(&buffer, name, std::forward<Ts>(args)...);
+    Poly& created = *std::launder(reinterpret_cast<Poly*>(&buffer));
+    Poly result{std::move(created)};
+    created.~Poly();
+    return result;
+  }
+
+  /// create_into
+
+  /// Appends to `container` a `Poly` per record. A record is tuple-like:
+  /// the name, then the arguments. Containers providing
+  /// `emplace_back_with`, as `PolyVector` does, get the values constructed
+  /// in place, others get them through `push_back`.
+  template <typename Container, typename Records>
+  void create_into(Container& container, Records const& records) const {
+    if constexpr (details::has_reserve<Container>::value)
+      container.reserve(container.size() + std::size(records));
+    for (auto const& record : records) {
+      std::apply(
+          [&](auto const& name, auto const&... args) {
+            auto construct = [&](void* dst) {
+              create_at(dst, name, args...);
+            };
+            if constexpr (details::has_emplace_back_with<
+                              Container, decltype(construct)>::value)
+              container.emplace_back_with(construct);
+            else
+              container.push_back(create(name, args...));
+          },
+          record);
+    }
+  }
+
+private:
+  struct Entry {
+    std::string name;
+    Construct construct;
+  };
+
+  auto slot_of(std::uint64_t hash, std::uint32_t seed) const noexcept
+      -> std::size_t {
+    return static_cast<std::size_t>(details::mix_hash(hash ^ seed)) &
+           (slots_.size() - 1);
+  }
+
+  auto find(std::string_view name) const noexcept -> Entry const* {
+    if (!frozen())
+      return nullptr;
+    std::uint64_t const hash = details::name_hash(name);
+    std::uint32_t const seed = seeds_[hash & (seeds_.size() - 1)];
+    std::uint32_t const index = slots_[slot_of(hash, seed)];
+    if (index == Empty)
+      return nullptr;
+    Entry const& entry = entries_[index];
+    return entry.name == name ? &entry : nullptr;
+  }
+
+  // Hash and displace: the names are grouped in buckets by hash, then the
+  // biggest buckets first get a seed which sends all their names to free
+  // slots. Returns false if some bucket found no seed.
+  auto try_freeze(std::size_t nb_slots) -> bool {
+    std::size_t nb_buckets = 1;
+    while (2 * nb_buckets < entries_.size())
+      nb_buckets *= 2;
+    std::vector<std::uint64_t> hashes;
+    std::vector<std::vector<std::uint32_t>> buckets(nb_buckets);
+    for (std::size_t i = 0; i < entries_.size(); ++i) {
+      hashes.push_back(details::name_hash(entries_[i].name));
+      buckets[hashes[i] & (nb_buckets - 1)].push_back(std::uint32_t(i));
+    }
+    std::vector<std::size_t> order(nb_buckets);
+    for (std::size_t b = 0; b < nb_buckets; ++b)
+      order[b] = b;
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) {
+                       return buckets[a].size() > buckets[b].size();
+                     });
+
+    seeds_.assign(nb_buckets, 0);
+    slots_.assign(nb_slots, Empty);
+    std::vector<std::size_t> taken;
+    for (std::size_t b : order) {
+      bool placed = buckets[b].empty();
+      for (std::uint32_t seed = 0; !placed && seed < MaxSeed; ++seed) {
+        taken.clear();
+        placed = true;
+        for (std::uint32_t i : buckets[b]) {
+          std::size_t const slot = slot_of(hashes[i], seed);
+          if (slots_[slot] != Empty) {
+            placed = false;
+            break;
+          }
+          slots_[slot] = i;
+          taken.push_back(slot);
+        }
+        if (placed) {
+          seeds_[b] = seed;
+        } else {
+          for (std::size_t slot : taken)
+            slots_[slot] = Empty;
+        }
+      }
+      if (!placed) {
+        slots_.clear();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static constexpr std::uint32_t Empty = ~std::uint32_t{0};
+  static constexpr std::uint32_t MaxSeed = 1 << 16;
+
+  std::vector<Entry> entries_;
+  std::vector<std::uint32_t> seeds_;
+  std::vector<std::uint32_t> slots_; // index in entries_, or Empty
+};
+
+} // namespace jv
+
+#endif
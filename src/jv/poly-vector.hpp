@@ -0,0 +1,184 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_POLY_VECTOR_HPP
+#define JVERNAY_UTILS_POLY_VECTOR_HPP
+
+#include <jv/uninitialized.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+/// Contiguous growable array of `Poly`, typically a `BoundedPoly`.
+///
+/// Growth, insertion and erasure relocate the elements with
+/// `uninitialized_relocate`, which is a single `memcpy` for types marked
+/// with `is_trivially_relocatable`, instead of a move and a destruction per
+/// element.
+template <typename Poly> class PolyVector {
+  static_assert(std::is_nothrow_move_constructible_v<Poly>);
+  static_assert(std::is_nothrow_destructible_v<Poly>);
+
+public:
+  using value_type = Poly;
+  using size_type = std::size_t;
+  using iterator = Poly*;
+  using const_iterator = Poly const*;
+
+  /// CONSTRUCTORS
+
+  PolyVector() noexcept = default;
+
+  PolyVector(PolyVector&& other) noexcept
+      : data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)},
+        capacity_{std::exchange(other.capacity_, 0)} {}
+
+  auto operator=(PolyVector&& other) noexcept -> PolyVector& {
+    PolyVector moved{std::move(other)};
+    std::swap(data_, moved.data_);
+    std::swap(size_, moved.size_);
+    std::swap(capacity_, moved.capacity_);
+    return *this;
+  }
+
+  /// DESTRUCTOR
+
+  ~PolyVector() noexcept {
+    clear();
+    if (data_ != nullptr)
+      std::allocator<Poly>{}.deallocate(data_, capacity_);
+  }
+
+  /// reserve
+
+  void reserve(std::size_t capacity) {
+    if (capacity <= capacity_)
+      return;
+    Poly* data = std::allocator<Poly>{}.allocate(capacity);
+    uninitialized_relocate(data_, data_ + size_, data);
+    if (data_ != nullptr)
+      std::allocator<Poly>{}.deallocate(data_, capacity_);
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  /// emplace_back
+
+  template <typename Derived, typename... Args>
+  auto emplace_back(Args&&... args) -> Poly& {
+    grow_for_one();
+    Poly* result = new (data_ + size_)
+        Poly(std::in_place_type_t<Derived>{}, std::forward<Args>(args)...);
+    ++size_;
+    return *result;
+  }
+
+  /// push_back
+
+  auto push_back(Poly poly) -> Poly& {
+    grow_for_one();
+    Poly* result = new (data_ + size_) Poly(std::move(poly));
+    ++size_;
+    return *result;
+  }
+
+  /// emplace_back_with
+
+  /// Calls `construct(slot)`, which must construct a `Poly` at `slot`, for
+  /// instance through a `PolyFactory`: the value is built in place.
+  template <typename Construct>
+  auto emplace_back_with(Construct&& construct) -> Poly& {
+    grow_for_one();
+    construct(static_cast<void*>(data_ + size_));
+    ++size_;
+    return data_[size_ - 1];
+  }
+
+  /// insert
+
+  /// Inserts `poly` before position `index`.
+  auto insert(std::size_t index, Poly poly) -> Poly& {
+    grow_for_one();
+    uninitialized_relocate(data_ + index, data_ + size_, data_ + index + 1);
+    Poly* result = new (data_ + index) Poly(std::move(poly));
+    ++size_;
+    return *result;
+  }
+
+  /// erase
+
+  void erase(std::size_t index) noexcept {
+    data_[index].~Poly();
+    uninitialized_relocate(data_ + index + 1, data_ + size_, data_ + index);
+    --size_;
+  }
+
+  /// pop_back
+
+  void pop_back() noexcept { data_[--size_].~Poly(); }
+
+  /// clear
+
+  void clear() noexcept {
+    jv::destroy(data_, data_ + size_);
+    size_ = 0;
+  }
+
+  /// Destroys the elements in parallel, on the threads of `pool`, typically
+  /// a `ThreadPool`, by chunks of `grain` elements. Worth it when
+  /// destructors free memory or other resources.
+  template <typename Pool>
+  void clear(Pool& pool, std::size_t grain = 4096) {
+    pool.parallel_for(0, size_, grain,
+                      [this](std::size_t first, std::size_t last) {
+                        jv::destroy(data_ + first, data_ + last);
+                      });
+    size_ = 0;
+  }
+
+  /// ELEMENT ACCESS
+
+  auto operator[](std::size_t index) noexcept -> Poly& { return data_[index]; }
+
+  auto operator[](std::size_t index) const noexcept -> Poly const& {
+    return data_[index];
+  }
+
+  auto data() noexcept -> Poly* { return data_; }
+  auto data() const noexcept -> Poly const* { return data_; }
+
+  auto size() const noexcept -> std::size_t { return size_; }
+  auto capacity() const noexcept -> std::size_t { return capacity_; }
+  auto empty() const noexcept -> bool { return size_ == 0; }
+
+  /// ITERATORS
+
+  auto begin() noexcept -> iterator { return data_; }
+  auto end() noexcept -> iterator { return data_ + size_; }
+  auto begin() const noexcept -> const_iterator { return data_; }
+  auto end() const noexcept -> const_iterator { return data_ + size_; }
+
+private:
+  void grow_for_one() {
+    if (size_ == capacity_)
+      reserve(std::max<std::size_t>(2 * capacity_, 4));
+  }
+
+  Poly* data_ = nullptr;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = 0;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,126 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_PREFETCH_HPP
+#define JVERNAY_UTILS_PREFETCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace jv {
+
+/// Size of the cache lines brought by `prefetch`.
+constexpr std::size_t CacheLineSize = 64;
+
+/// prefetch
+
+/// Hints the CPU to bring the cache lines of `[ptr, ptr + size)` in cache.
+/// Does nothing on compilers without a prefetch intrinsic.
+inline void prefetch(void const* ptr, std::size_t size = 1) noexcept {
+  auto first = reinterpret_cast<std::uintptr_t>(ptr) & ~(CacheLineSize - 1);
+  auto last = reinterpret_cast<std::uintptr_t>(ptr) + size;
+  for (; first < last; first += CacheLineSize) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(reinterpret_cast<void const*>(first));
+#elif defined(_MSC_VER)
+    _mm_prefetch(reinterpret_cast<char const*>(first), _MM_HINT_T0);
+#endif
+  }
+}
+
+namespace details {
+
+template <typename T, typename = void> struct has_polymorphic_get {
+  static constexpr bool value = false;
+};
+
+template <typename T>
+struct has_polymorphic_get<
+    T, std::void_t<decltype(std::declval<T const&>().get())>> {
+  static constexpr bool value = std::is_polymorphic_v<
+      std::remove_reference_t<decltype(std::declval<T const&>().get())>>;
+};
+
+// Object whose virtual table is used when calling `f` on `value`: the
+// `Base` of a `BoundedPoly`, or the value itself.
+template <typename T>
+auto polymorphic_object(T const& value) noexcept -> void const* {
+  if constexpr (has_polymorphic_get<T>::value)
+    return &value.get();
+  else if constexpr (std::is_polymorphic_v<T>)
+    return &value;
+  else
+    return nullptr;
+}
+
+// Object reached by an element of a range: the pointee for pointers, so
+// that ranges of pointers prefetch the objects and not the pointers.
+template <typename T> auto target(T const& element) noexcept -> T const& {
+  return element;
+}
+
+template <typename T> auto target(T* element) noexcept -> T const& {
+  return *element;
+}
+
+} // namespace details
+
+/// prefetch_vtable
+
+/// Hints the CPU to bring the virtual table of `value` in cache. This reads
+/// the virtual pointer, so `value` itself should already be in cache.
+/// Both Itanium and MSVC ABIs put the virtual pointer at the start of the
+/// object.
+template <typename T> void prefetch_vtable(T const& value) noexcept {
+  if (void const* object = details::polymorphic_object(value))
+    prefetch(*static_cast<void const* const*>(object));
+}
+
+/// for_each_prefetch
+
+/// Calls `f` on each element of a random-access `range`, prefetching the
+/// element `distance` positions ahead, and the virtual table of the element
+/// `distance / 2` positions ahead, whose lines should have arrived by then.
+/// For a range of pointers, the pointed objects are prefetched instead.
+/// Worth it for elements spanning several cache lines, or when the hardware
+/// prefetcher cannot guess the next address; `distance == 0` disables
+/// prefetching.
+template <typename Range, typename F>
+void for_each_prefetch(Range&& range, F&& f, std::size_t distance = 8) {
+  using std::begin;
+  using std::end;
+  auto first = begin(range);
+  auto const size = static_cast<std::size_t>(end(range) - first);
+  auto fetch = [](auto const& element) noexcept {
+    auto const& object = details::target(element);
+    prefetch(&object, sizeof(object));
+  };
+
+  std::size_t const half = distance / 2;
+  if (distance != 0) // warm-up: the first elements have no one to fetch them
+    for (std::size_t i = 0; i < distance && i < size; ++i)
+      fetch(first[i]);
+  for (std::size_t i = 0; i < size; ++i) {
+    if (distance != 0) {
+      if (i + distance < size)
+        fetch(first[i + distance]);
+      if (i + half < size)
+        prefetch_vtable(details::target(first[i + half]));
+    }
+    f(first[i]);
+  }
+}
+
+} // namespace jv
+
+#endif
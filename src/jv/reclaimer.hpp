@@ -0,0 +1,108 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_RECLAIMER_HPP
+#define JVERNAY_UTILS_RECLAIMER_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+/// Background thread destroying the values handed to it.
+///
+/// `defer(std::move(container))` moves the container (for a `PolyVector` or
+/// a `std::vector`, only its buffer) and returns immediately: the elements
+/// are destroyed and the memory is freed by the reclaimer thread. It keeps
+/// the destruction of large containers, for instance the old version
+/// replaced at reconfiguration, off the calling thread.
+class Reclaimer {
+public:
+  /// CONSTRUCTORS
+
+  Reclaimer() : thread_{[this] { work(); }} {}
+
+  Reclaimer(Reclaimer const&) = delete;
+  auto operator=(Reclaimer const&) -> Reclaimer& = delete;
+
+  /// DESTRUCTOR
+
+  /// Destroys the values not destroyed yet, then stops the thread.
+  ~Reclaimer() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+  /// defer
+
+  /// Hands `value` to the reclaimer thread, which destroys it later. If
+  /// this throws (out of memory), `value` is unchanged.
+  template <typename T> void defer(T&& value) {
+    static_assert(!std::is_lvalue_reference_v<T>, "pass an rvalue");
+    auto garbage = std::make_unique<Holder<T>>(std::move(value));
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      queue_.push_back(std::move(garbage));
+    }
+    wake_.notify_one();
+  }
+
+  /// flush
+
+  /// Waits until every value deferred so far is destroyed.
+  void flush() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    idle_.wait(lock, [this] { return queue_.empty() && !busy_; });
+  }
+
+private:
+  struct Garbage {
+    virtual ~Garbage() noexcept = default;
+  };
+
+  template <typename T> struct Holder final : Garbage {
+    T value;
+    explicit Holder(T&& v) : value(std::move(v)) {}
+  };
+
+  void work() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) // and stopping
+        return;
+      std::unique_ptr<Garbage> garbage = std::move(queue_.front());
+      queue_.pop_front();
+      busy_ = true;
+      lock.unlock();
+      garbage.reset(); // the destruction itself, without the lock
+      lock.lock();
+      busy_ = false;
+      if (queue_.empty())
+        idle_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_, idle_;
+  std::deque<std::unique_ptr<Garbage>> queue_;
+  bool busy_ = false;
+  bool stopping_ = false;
+  std::thread thread_; // last: started once the members above exist
+};
+
+} // namespace jv
+
+#endif
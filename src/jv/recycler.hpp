@@ -0,0 +1,215 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_RECYCLER_HPP
+#define JVERNAY_UTILS_RECYCLER_HPP
+
+#include <jv/uninitialized.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+// Stack of free objects of type T, in raw slots allocated once.
+template <typename T> class FreeList {
+  using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+public:
+  explicit FreeList(std::size_t capacity)
+      : slots_{new Slot[capacity]}, capacity_{capacity} {}
+
+  FreeList(FreeList&&) noexcept = default;
+
+  ~FreeList() noexcept {
+    if (slots_ != nullptr)
+      jv::destroy(at(0), at(size_));
+  }
+
+  auto size() const noexcept -> std::size_t { return size_; }
+  auto full() const noexcept -> bool { return size_ == capacity_; }
+  auto back() noexcept -> T* { return at(size_ - 1); }
+
+  // Relocates src, which must be a T, into a free slot.
+  void push(T* src) noexcept { relocate_at(src, at(size_++)); }
+
+  // Moves src into a free slot, leaving it to be destroyed.
+  void push_moved(T& src) noexcept { new (at(size_++)) T(std::move(src)); }
+
+  // Relocates the back object into dst.
+  void pop_to(void* dst) noexcept {
+    relocate_at(at(--size_), static_cast<T*>(dst));
+  }
+
+private:
+  auto at(std::size_t i) noexcept -> T* {
+    return std::launder(reinterpret_cast<T*>(&slots_[i]));
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  std::size_t capacity_;
+  std::size_t size_ = 0;
+};
+
+} // namespace details
+
+/// Free lists of objects of `Types...`, all derived from `Base`, kept
+/// instead of being destroyed so that their resources (reserved buffers,
+/// hash maps) are reused.
+///
+/// `BoundedPoly::emplace_recycled<Derived>(recycler, args...)` resets the
+/// stored value with `reset(args...)` if it is already a `Derived`.
+/// Otherwise it takes a free `Derived`, resets it and relocates it into the
+/// `BoundedPoly`, and relocates the replaced value into its free list. The
+/// free lists are raw slots allocated up front: recycling never allocates,
+/// and relocating a trivially relocatable type is a `memcpy`.
+template <typename Base, typename... Types> class Recycler {
+  static_assert((std::is_base_of_v<Base, Types> && ...));
+  static_assert((std::is_nothrow_move_constructible_v<Types> && ...));
+
+public:
+  /// CONSTRUCTORS
+
+  /// Keeps at most `capacity` free objects of each type.
+  explicit Recycler(std::size_t capacity = 64)
+      : lists_{details::FreeList<Types>{capacity}...} {}
+
+  /// reset_stored
+
+  /// Calls `value.reset(args...)` and returns `true` if `value` is a
+  /// `Derived`, and `Derived` one of `Types...`.
+  template <typename Derived, typename... Args>
+  auto reset_stored(Base& value, Args&&... args) -> bool {
+    if constexpr (is_recycled<Derived>()) {
+      if (typeid(value) == typeid(Derived)) {
+        static_cast<Derived&>(value).reset(std::forward<Args>(args)...);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// reset_free
+
+  /// Calls `reset(args...)` on the next free `Derived` and returns it, or
+  /// returns `nullptr` if there is none. It stays free until `pop_free`.
+  template <typename Derived, typename... Args>
+  auto reset_free(Args&&... args) -> Derived* {
+    if constexpr (is_recycled<Derived>()) {
+      auto& list = list_of<Derived>();
+      if (list.size() != 0) {
+        list.back()->reset(std::forward<Args>(args)...);
+        return list.back();
+      }
+    }
+    return nullptr;
+  }
+
+  /// pop_free
+
+  /// Relocates the next free `Derived`, returned by `reset_free`, into the
+  /// uninitialized `dst`.
+  template <typename Derived> void pop_free(void* dst) noexcept {
+    if constexpr (is_recycled<Derived>()) // else there is no free Derived
+      list_of<Derived>().pop_to(dst);
+  }
+
+  /// retire
+
+  /// Ends the lifetime of `value`: relocates it into its free list if its
+  /// type is one of `Types...` and the list is not full, destroys it
+  /// otherwise.
+  void retire(Base& value) noexcept {
+    std::type_info const& type = typeid(value);
+    if (!(try_retire<Types>(type, value) || ...))
+      value.~Base();
+  }
+
+  /// recycle
+
+  /// Moves `value` into its free list, if its type is one of `Types...` and
+  /// the list is not full, for values about to be destroyed. `value` is left
+  /// moved-from. Returns whether `value` was recycled.
+  auto recycle(Base& value) noexcept -> bool {
+    std::type_info const& type = typeid(value);
+    bool recycled = false;
+    (void)(try_recycle<Types>(type, value, recycled) || ...);
+    return recycled;
+  }
+
+  /// Recycles the values of the range of `BoundedPoly` [first, last).
+  template <typename It> void recycle(It first, It last) noexcept {
+    for (; first != last; ++first)
+      recycle(first->get());
+  }
+
+  /// nb_free
+
+  /// Number of free `Derived`.
+  template <typename Derived> auto nb_free() const noexcept -> std::size_t {
+    return std::get<index_of<Derived>()>(lists_).size();
+  }
+
+private:
+  template <typename Derived>
+  static constexpr auto index_of() noexcept -> std::size_t {
+    constexpr bool found[] = {std::is_same_v<Derived, Types>...};
+    for (std::size_t i = 0; i < sizeof...(Types); ++i)
+      if (found[i])
+        return i;
+    return sizeof...(Types);
+  }
+
+  template <typename Derived>
+  static constexpr auto is_recycled() noexcept -> bool {
+    return index_of<Derived>() < sizeof...(Types);
+  }
+
+  template <typename Derived>
+  auto list_of() noexcept -> details::FreeList<Derived>& {
+    static_assert(is_recycled<Derived>(), "not recycled");
+    return std::get<index_of<Derived>()>(lists_);
+  }
+
+  // Returns whether value was a T, which is then retired.
+  template <typename T>
+  auto try_retire(std::type_info const& type, Base& value) noexcept -> bool {
+    if (type != typeid(T))
+      return false;
+    auto& list = list_of<T>();
+    if (list.full())
+      value.~Base();
+    else
+      list.push(&static_cast<T&>(value));
+    return true;
+  }
+
+  // Returns whether value is a T.
+  template <typename T>
+  auto try_recycle(std::type_info const& type, Base& value,
+                   bool& recycled) noexcept -> bool {
+    if (type != typeid(T))
+      return false;
+    auto& list = list_of<T>();
+    recycled = !list.full();
+    if (recycled)
+      list.push_moved(static_cast<T&>(value));
+    return true;
+  }
+
+  std::tuple<details::FreeList<Types>...> lists_;
+};
+
+} // namespace jv
+
+#endif
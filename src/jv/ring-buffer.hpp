@@ -0,0 +1,233 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_RING_BUFFER_HPP
+#define JVERNAY_UTILS_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+/// Bounded lock-free multi-producer multi-consumer queue, with its slots
+/// stored inline.
+///
+/// Each cell carries a sequence number telling whether it is free for the
+/// producer of a given round or holds a value for its consumer (D. Vyukov's
+/// bounded queue). Values are constructed and consumed in place, so a
+/// `BoundedPoly` never needs to be moved in or out of the ring.
+template <typename T, std::size_t Capacity> class MpmcRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+  static_assert(std::is_nothrow_destructible_v<T>);
+
+  static constexpr std::size_t Mask = Capacity - 1;
+
+  struct Cell {
+    std::atomic<std::size_t> sequence;
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+  };
+
+public:
+  using value_type = T;
+
+  /// CONSTRUCTORS
+
+  MpmcRing() noexcept {
+    for (std::size_t i = 0; i < Capacity; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpmcRing(MpmcRing const&) = delete;
+  auto operator=(MpmcRing const&) -> MpmcRing& = delete;
+
+  /// DESTRUCTOR
+
+  /// Destroys the values which were not consumed.
+  ~MpmcRing() noexcept {
+    while (try_consume([](T&) noexcept {}))
+      ;
+  }
+
+  /// try_emplace
+
+  /// Constructs `T(args...)` in the next free cell. Returns `false` if the
+  /// ring is full. Once a cell is claimed, construction must succeed or the
+  /// consumers would wait for it forever, so an exception terminates.
+  template <typename... Args>
+  auto try_emplace(Args&&... args) noexcept -> bool {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & Mask];
+      std::size_t const seq = cell->sequence.load(std::memory_order_acquire);
+      auto const diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false; // the cell still holds last round's value
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    new (&cell->storage) T(std::forward<Args>(args)...);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// try_consume
+
+  /// Calls `f(T&)` on the oldest value, then destroys it. Returns `false` if
+  /// the ring is empty.
+  template <typename F> auto try_consume(F&& f) -> bool {
+    std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & Mask];
+      std::size_t const seq = cell->sequence.load(std::memory_order_acquire);
+      auto const diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T& value = reinterpret_cast<T&>(cell->storage);
+    struct Release { // frees the cell even if `f` throws
+      Cell* cell;
+      std::size_t next;
+      T& value;
+      ~Release() {
+        value.~T();
+        cell->sequence.store(next, std::memory_order_release);
+      }
+    } release{cell, pos + Capacity, value};
+    f(value);
+    return true;
+  }
+
+  /// empty
+
+  /// Snapshot only: other threads may push or pop concurrently.
+  auto empty() const noexcept -> bool {
+    std::size_t const pos = dequeue_pos_.load(std::memory_order_relaxed);
+    return cells_[pos & Mask].sequence.load(std::memory_order_acquire) !=
+           pos + 1;
+  }
+
+  static constexpr auto capacity() noexcept -> std::size_t { return Capacity; }
+
+private:
+  Cell cells_[Capacity];
+  alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<std::size_t> dequeue_pos_{0};
+};
+
+/// Bounded wait-free single-producer single-consumer queue, with its slots
+/// stored inline.
+///
+/// Each side caches the position of the other one, so the shared counters are
+/// only read when the cached value says the ring looks full (or empty).
+template <typename T, std::size_t Capacity> class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of two");
+  static_assert(std::is_nothrow_destructible_v<T>);
+
+  static constexpr std::size_t Mask = Capacity - 1;
+
+  using Slot = std::aligned_storage_t<sizeof(T), alignof(T)>;
+
+public:
+  using value_type = T;
+
+  /// CONSTRUCTORS
+
+  SpscRing() noexcept = default;
+
+  SpscRing(SpscRing const&) = delete;
+  auto operator=(SpscRing const&) -> SpscRing& = delete;
+
+  /// DESTRUCTOR
+
+  /// Destroys the values which were not consumed.
+  ~SpscRing() noexcept {
+    while (try_consume([](T&) noexcept {}))
+      ;
+  }
+
+  /// try_emplace
+
+  /// Constructs `T(args...)` at the back. Returns `false` if the ring is full.
+  /// Must only be called by the producer thread.
+  template <typename... Args>
+  auto try_emplace(Args&&... args) noexcept(
+      std::is_nothrow_constructible_v<T, Args...>) -> bool {
+    std::size_t const tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == Capacity) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == Capacity)
+        return false;
+    }
+    new (&slots_[tail & Mask]) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// try_consume
+
+  /// Calls `f(T&)` on the front value, then destroys it. Returns `false` if
+  /// the ring is empty. Must only be called by the consumer thread.
+  template <typename F> auto try_consume(F&& f) -> bool {
+    std::size_t const head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_)
+        return false;
+    }
+    T& value = reinterpret_cast<T&>(slots_[head & Mask]);
+    struct Release { // frees the slot even if `f` throws
+      std::atomic<std::size_t>& head;
+      std::size_t next;
+      T& value;
+      ~Release() {
+        value.~T();
+        head.store(next, std::memory_order_release);
+      }
+    } release{head_, head + 1, value};
+    f(value);
+    return true;
+  }
+
+  /// empty
+
+  /// Snapshot only: the other side may push or pop concurrently.
+  auto empty() const noexcept -> bool {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  static constexpr auto capacity() noexcept -> std::size_t { return Capacity; }
+
+private:
+  Slot slots_[Capacity];
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  std::size_t head_cache_ = 0; // producer side
+  alignas(64) std::atomic<std::size_t> head_{0};
+  std::size_t tail_cache_ = 0; // consumer side
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,331 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_SEALED_POLY_HPP
+#define JVERNAY_UTILS_SEALED_POLY_HPP
+
+#include <jv/uninitialized.hpp>
+#include <jv/vtable-mover.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace jv {
+
+namespace details {
+
+template <typename T, typename... Ts> struct index_of;
+
+template <typename T, typename... Ts>
+struct index_of<T, T, Ts...> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct index_of<T, U, Ts...>
+    : std::integral_constant<std::size_t, 1 + index_of<T, Ts...>::value> {};
+
+template <std::size_t I, typename... Ts> struct nth_type;
+
+template <typename T, typename... Ts> struct nth_type<0, T, Ts...> {
+  using type = T;
+};
+
+template <std::size_t I, typename T, typename... Ts>
+struct nth_type<I, T, Ts...> : nth_type<I - 1, Ts...> {};
+
+} // namespace details
+
+/// Type abstractor for a closed set of `final` types derived from `Base`.
+///
+/// Like `BoundedPoly`, it stores the value inline and exposes it as a `Base`,
+/// so virtual calls through `operator->` keep working. But `visit` calls `f`
+/// with the concrete type: as every type is `final`, the calls made by `f` are
+/// direct, and can be inlined. Moves and destruction dispatch the same way.
+///
+/// The index of the type is not stored, which would cost an alignment per
+/// element: the virtual pointer of the value already identifies its type. It
+/// is compared with the vtables of `Ts`, recorded the first time each type is
+/// found through `typeid`, which also handles vtables duplicated across
+/// modules: each type records up to 4 of them. The first 8 types are
+/// dispatched by comparing with their first vtable, the others by a switch on
+/// the index.
+/// As for `BoundedPoly`, `Base` must be the first base of `Ts`, which must
+/// have no virtual base.
+template <typename Base, typename... Ts> class SealedPoly {
+  static_assert(sizeof...(Ts) > 0 && sizeof...(Ts) <= 255);
+  static_assert(std::is_polymorphic_v<Base>);
+  static_assert((std::is_final_v<Ts> && ...), "every type must be final");
+  static_assert((std::is_base_of_v<Base, Ts> && ...));
+  static_assert((std::is_nothrow_move_constructible_v<Ts> && ...));
+  static_assert((std::is_nothrow_destructible_v<Ts> && ...));
+
+  template <typename T>
+  static constexpr bool is_alternative_v = (std::is_same_v<T, Ts> || ...);
+
+  static constexpr std::size_t NbTypes = sizeof...(Ts);
+
+public:
+  /// index_of
+
+  template <typename T>
+  static constexpr std::size_t index_of_v =
+      details::index_of<T, Ts...>::value;
+
+  /// CONSTRUCTORS
+
+  template <typename Derived, typename = std::enable_if_t<
+                                  is_alternative_v<std::decay_t<Derived>>>>
+  SealedPoly(Derived&& derived) noexcept(
+      std::is_nothrow_constructible_v<std::decay_t<Derived>, Derived&&>) {
+    new (&storage_) std::decay_t<Derived>(std::forward<Derived>(derived));
+  }
+
+  template <typename Derived, typename... Args>
+  SealedPoly(std::in_place_type_t<Derived>, Args&&... args) {
+    static_assert(is_alternative_v<Derived>, "not one of the types");
+    new (&storage_) Derived(std::forward<Args>(args)...);
+  }
+
+  SealedPoly(SealedPoly const&) = delete;
+
+  SealedPoly(SealedPoly&& other) noexcept {
+    other.visit([this](auto& value) {
+      using T = std::decay_t<decltype(value)>;
+      new (&storage_) T(std::move(value));
+    });
+  }
+
+  /// ASSIGNMENT OPERATORS
+
+  auto operator=(SealedPoly const&) -> SealedPoly& = delete;
+
+  auto operator=(SealedPoly&& other) noexcept -> SealedPoly& {
+    if (this != &other) {
+      this->~SealedPoly();
+      new (this) SealedPoly(std::move(other));
+    }
+    return *this;
+  }
+
+  /// emplace
+
+  template <typename Derived, typename... Args>
+  void emplace(Args&&... args) noexcept {
+    static_assert(is_alternative_v<Derived>, "not one of the types");
+    static_assert(std::is_nothrow_constructible_v<Derived, Args...>);
+    this->~SealedPoly();
+    new (&storage_) Derived(std::forward<Args>(args)...);
+  }
+
+  /// DESTRUCTOR
+
+  ~SealedPoly() noexcept {
+    visit([](auto& value) {
+      using T = std::decay_t<decltype(value)>;
+      value.~T(); // not virtual: T is final
+    });
+  }
+
+  /// index
+
+  auto index() const noexcept -> std::size_t {
+    return index_from(0, details::vtable_of(&storage_));
+  }
+
+  template <typename T> auto holds() const noexcept -> bool {
+    return index() == index_of_v<T>;
+  }
+
+  /// get_if
+
+  template <typename T> auto get_if() noexcept -> T* {
+    return holds<T>() ? reinterpret_cast<T*>(&storage_) : nullptr;
+  }
+
+  template <typename T> auto get_if() const noexcept -> T const* {
+    return holds<T>() ? reinterpret_cast<T const*>(&storage_) : nullptr;
+  }
+
+  /// visit
+
+  /// Calls `f` with the stored value as its concrete type. Every call must
+  /// return the same type.
+  template <typename F> decltype(auto) visit(F&& f) {
+    return visit_first<0>(*this, f, details::vtable_of(&storage_));
+  }
+
+  template <typename F> decltype(auto) visit(F&& f) const {
+    return visit_first<0>(*this, f, details::vtable_of(&storage_));
+  }
+
+  /// get
+
+  auto get() noexcept -> Base& {
+    return visit([](auto& value) -> Base& { return value; });
+  }
+
+  auto get() const noexcept -> Base const& {
+    return visit([](auto const& value) -> Base const& { return value; });
+  }
+
+  /// DEREFERENCE OPERATORS
+
+  auto operator*() noexcept -> Base& { return get(); }
+  auto operator*() const noexcept -> Base const& { return get(); }
+  auto operator->() noexcept -> Base* { return &get(); }
+  auto operator->() const noexcept -> Base const* { return &get(); }
+
+  /// swap
+
+  void swap(SealedPoly& other) noexcept {
+    SealedPoly tmp{std::move(other)};
+    other = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+private:
+  auto index_from(std::size_t first, void const* vtable) const noexcept
+      -> std::size_t {
+    for (std::size_t i = first; i < NbTypes; ++i)
+      for (auto const& recorded : vtables_[i])
+        if (recorded.load(std::memory_order_relaxed) == vtable)
+          return i;
+    return find_index(vtable);
+  }
+
+  // Slow path, once per vtable: finds the type with typeid, and records the
+  // vtable in a free slot of the type. Recorded vtables are never replaced,
+  // so duplicates of a vtable (one per module) do not evict each other; past
+  // NbVtables of them, the others always take this path.
+  auto find_index(void const* vtable) const noexcept -> std::size_t {
+    auto const& base =
+        *std::launder(reinterpret_cast<Base const*>(&storage_));
+    std::type_info const& type = typeid(base);
+    std::type_info const* const types[] = {&typeid(Ts)...};
+    std::size_t i = 0;
+    for (; i + 1 < NbTypes; ++i) // else the last one
+      if (*types[i] == type)
+        break;
+    for (auto& recorded : vtables_[i]) {
+      void const* expected = nullptr;
+      if (recorded.compare_exchange_strong(expected, vtable,
+                                           std::memory_order_relaxed) ||
+          expected == vtable)
+        break;
+    }
+    return i;
+  }
+
+  // Compares the vtable with those of the first types, calling f directly
+  // on a match: cheaper than finding the index, then switching on it. The
+  // other types go through the switch.
+  template <std::size_t I, typename Self, typename F>
+  static decltype(auto) visit_first(Self& self, F& f, void const* vtable) {
+    if constexpr (I == NbTypes || I == 8) {
+      return visit_from<0>(self, f, self.index_from(I, vtable));
+    } else {
+      if (vtables_[I][0].load(std::memory_order_relaxed) == vtable)
+        return visit_at<I>(self, f);
+      return visit_first<I + 1>(self, f, vtable);
+    }
+  }
+
+  template <std::size_t I, typename Self, typename F>
+  static decltype(auto) visit_at(Self& self, F& f) {
+    using T = typename details::nth_type<I, Ts...>::type;
+    using Qualified = std::conditional_t<std::is_const_v<Self>, T const, T>;
+    return f(*std::launder(reinterpret_cast<Qualified*>(&self.storage_)));
+  }
+
+  // A switch over 8 types at a time, which compilers turn into a jump table
+  // or a few branches, with the calls of f inlined. Cases past the last
+  // type are never taken.
+  template <std::size_t First, typename Self, typename F>
+  static decltype(auto) visit_from(Self& self, F& f, std::size_t index) {
+    constexpr auto at = [](std::size_t i) {
+      return First + i < NbTypes ? First + i : NbTypes - 1;
+    };
+    switch (index - First) {
+    case 0: return visit_at<at(0)>(self, f);
+    case 1: return visit_at<at(1)>(self, f);
+    case 2: return visit_at<at(2)>(self, f);
+    case 3: return visit_at<at(3)>(self, f);
+    case 4: return visit_at<at(4)>(self, f);
+    case 5: return visit_at<at(5)>(self, f);
+    case 6: return visit_at<at(6)>(self, f);
+    case 7: return visit_at<at(7)>(self, f);
+    default:
+      if constexpr (First + 8 < NbTypes)
+        return visit_from<First + 8>(self, f, index);
+      else
+        return visit_at<NbTypes - 1>(self, f);
+    }
+  }
+
+  // vtables of each type, in the order they were found, then nullptr
+  static constexpr std::size_t NbVtables = 4;
+  static inline std::atomic<void const*> vtables_[NbTypes][NbVtables] = {};
+
+  std::aligned_union_t<0, Ts...> storage_;
+};
+
+/// visit
+
+template <typename F, typename Base, typename... Ts>
+decltype(auto) visit(F&& f, SealedPoly<Base, Ts...>& poly) {
+  return poly.visit(std::forward<F>(f));
+}
+
+template <typename F, typename Base, typename... Ts>
+decltype(auto) visit(F&& f, SealedPoly<Base, Ts...> const& poly) {
+  return poly.visit(std::forward<F>(f));
+}
+
+/// for_each
+
+namespace details {
+
+template <typename T> struct is_sealed_poly : std::false_type {};
+
+template <typename Base, typename... Ts>
+struct is_sealed_poly<SealedPoly<Base, Ts...>> : std::true_type {};
+
+template <typename Range>
+using range_value_t = std::remove_cv_t<std::remove_reference_t<decltype(
+    *std::begin(std::declval<Range&>()))>>;
+
+template <typename Range, typename = void>
+struct is_sealed_poly_range : std::false_type {};
+
+template <typename Range>
+struct is_sealed_poly_range<Range, std::void_t<range_value_t<Range>>>
+    : is_sealed_poly<range_value_t<Range>> {};
+
+} // namespace details
+
+/// Calls `f` with the concrete type of every `SealedPoly` of `range`.
+template <typename Range, typename F,
+          typename = std::enable_if_t<
+              details::is_sealed_poly_range<Range>::value>>
+void for_each(Range&& range, F&& f) {
+  for (auto&& poly : range)
+    poly.visit(f);
+}
+
+/// A `SealedPoly` is trivially relocatable if all its types are.
+template <typename Base, typename... Ts>
+struct is_trivially_relocatable<SealedPoly<Base, Ts...>> {
+  static constexpr bool value = (is_trivially_relocatable_v<Ts> && ...);
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,431 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_SHARDED_EVALUATOR_HPP
+#define JVERNAY_UTILS_SHARDED_EVALUATOR_HPP
+
+// POSIX only: workers are forked processes talking over Unix domain sockets.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace jv {
+
+/// Appends values to a byte buffer, in host byte order.
+class WireWriter {
+public:
+  explicit WireWriter(std::string& buffer) noexcept : buffer_{&buffer} {}
+
+  void write(void const* data, std::size_t size) {
+    buffer_->append(static_cast<char const*>(data), size);
+  }
+
+  template <typename T> void write(T const& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    write(&value, sizeof(T));
+  }
+
+private:
+  std::string* buffer_;
+};
+
+/// Reads values written by a `WireWriter`. Throws `std::runtime_error` when
+/// reading past the end.
+class WireReader {
+public:
+  WireReader(char const* data, std::size_t size) noexcept
+      : data_{data}, end_{data + size} {}
+
+  void read(void* data, std::size_t size) {
+    if (static_cast<std::size_t>(end_ - data_) < size)
+      throw std::runtime_error{"jv::WireReader: truncated message"};
+    std::memcpy(data, data_, size);
+    data_ += size;
+  }
+
+  template <typename T> auto read() -> T {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    read(&value, sizeof(T));
+    return value;
+  }
+
+private:
+  char const* data_;
+  char const* end_;
+};
+
+/// Associates the derived types of a `BoundedPoly` with stable identifiers,
+/// so that they can be sent to another process, which may be another binary.
+///
+/// Registered types provide `void encode(WireWriter&) const` and
+/// `static Derived decode(WireReader&)`. Each element is sent as its type
+/// identifier, the size of its encoding, then its encoding.
+template <typename Poly> class WireRegistry {
+public:
+  using Base = std::remove_reference_t<decltype(std::declval<Poly&>().get())>;
+  using TypeId = std::uint32_t;
+
+  /// add
+
+  /// Registers `Derived` under `type_id`. Throws `std::invalid_argument` if
+  /// either is already registered.
+  template <typename Derived> void add(TypeId type_id) {
+    static_assert(Poly::template can_handle_v<Derived>);
+    std::type_index const type{typeid(Derived)};
+    if (encoders_.count(type) != 0 || decoders_.count(type_id) != 0)
+      throw std::invalid_argument{"jv::WireRegistry: duplicate type"};
+    encoders_.emplace(type,
+                      Encoder{type_id, [](Base const& value, WireWriter& out) {
+                                static_cast<Derived const&>(value).encode(out);
+                              }});
+    decoders_.emplace(type_id, [](WireReader& in) -> Poly {
+      return Poly{Derived::decode(in)};
+    });
+  }
+
+  /// encode
+
+  /// Throws `std::invalid_argument` if the dynamic type of `value` is not
+  /// registered.
+  void encode(Base const& value, std::string& buffer) const {
+    auto const it = encoders_.find(std::type_index{typeid(value)});
+    if (it == encoders_.end())
+      throw std::invalid_argument{"jv::WireRegistry: unregistered type"};
+    WireWriter out{buffer};
+    out.write(it->second.type_id);
+    std::size_t const size_at = buffer.size();
+    out.write(std::uint32_t{0}); // patched once the encoding is known
+    it->second.encode(value, out);
+    auto const size = static_cast<std::uint32_t>(buffer.size() - size_at -
+                                                 sizeof(std::uint32_t));
+    std::memcpy(&buffer[size_at], &size, sizeof(size));
+  }
+
+  /// decode
+
+  /// Throws `std::runtime_error` for an unknown type or a truncated encoding.
+  auto decode(WireReader& in) const -> Poly {
+    auto const type_id = in.read<TypeId>();
+    auto const size = in.read<std::uint32_t>();
+    auto const it = decoders_.find(type_id);
+    if (it == decoders_.end())
+      throw std::runtime_error{"jv::WireRegistry: unknown type identifier"};
+    std::string bytes(size, '\0');
+    in.read(&bytes[0], size);
+    WireReader element{bytes.data(), bytes.size()};
+    return it->second(element);
+  }
+
+private:
+  struct Encoder {
+    TypeId type_id;
+    void (*encode)(Base const&, WireWriter&);
+  };
+
+  std::unordered_map<std::type_index, Encoder> encoders_;
+  std::unordered_map<TypeId, Poly (*)(WireReader&)> decoders_;
+};
+
+/// Evaluates reductions over containers of `Poly` by splitting them in
+/// contiguous shards, one per worker process.
+///
+/// Workers are forked by `start`, so they know the registry and the
+/// reductions, which are addressed by identifier as a remote node would.
+/// `Result` travels as raw bytes, so it must be trivially copyable. Each shard
+/// is reduced from `init`, then the shard results are merged in order.
+///
+/// `start` must be called before the process starts any other thread. The
+/// child of a multithreaded process only gets the forking thread, so a lock
+/// held by another one at that time, such as the allocator's, would never be
+/// released in the worker. The workers are reaped by `stop` and the
+/// destructor.
+template <typename Poly, typename Result> class ShardedEvaluator {
+  static_assert(std::is_trivially_copyable_v<Result>);
+
+public:
+  using Base = typename WireRegistry<Poly>::Base;
+  using ReductionId = std::uint32_t;
+
+  /// CONSTRUCTORS
+
+  explicit ShardedEvaluator(WireRegistry<Poly> registry) noexcept
+      : registry_{std::move(registry)} {}
+
+  ShardedEvaluator(ShardedEvaluator const&) = delete;
+  auto operator=(ShardedEvaluator const&) -> ShardedEvaluator& = delete;
+
+  /// DESTRUCTOR
+
+  /// Closing the sockets makes the workers exit.
+  ~ShardedEvaluator() noexcept { stop(); }
+
+  /// add_reduction
+
+  /// Registers `reduce(Result, Base const&) -> Result` and
+  /// `merge(Result, Result) -> Result`. Must be called before `start`.
+  template <typename Reduce, typename Merge>
+  auto add_reduction(Result init, Reduce reduce, Merge merge) -> ReductionId {
+    reductions_.push_back(Reduction{init, std::move(reduce), std::move(merge)});
+    return static_cast<ReductionId>(reductions_.size() - 1);
+  }
+
+  /// start
+
+  /// Forks `nb_workers` processes, while this one has no other thread.
+  /// Throws `std::system_error` on failure.
+  void start(std::size_t nb_workers) {
+    for (std::size_t i = 0; i < nb_workers; ++i) {
+      int fds[2];
+      if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+        throw_errno("socketpair");
+      pid_t const pid = ::fork();
+      if (pid < 0) {
+        ::close(fds[0]);
+        ::close(fds[1]);
+        throw_errno("fork");
+      }
+      if (pid == 0) {
+        ::close(fds[0]);
+        for (Worker const& other : workers_) // or they would never see EOF
+          ::close(other.fd);
+        serve(fds[1]);
+        ::_exit(0); // skips the parent's atexit handlers
+      }
+      ::close(fds[1]);
+      workers_.push_back(Worker{pid, fds[0]});
+    }
+  }
+
+  /// stop
+
+  void stop() noexcept {
+    for (Worker const& worker : workers_) {
+      ::close(worker.fd);
+      int status;
+      while (::waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+      }
+    }
+    workers_.clear();
+  }
+
+  /// size
+
+  /// Number of worker processes.
+  auto size() const noexcept -> std::size_t { return workers_.size(); }
+
+  /// evaluate
+
+  /// Reduces `[first, last)` with the given reduction. Without workers, the
+  /// range is reduced in this process. Throws `std::invalid_argument` for an
+  /// unregistered type, and `std::runtime_error` if a worker fails. If the
+  /// communication itself fails, the workers are stopped.
+  template <typename It>
+  auto evaluate(It first, It last, ReductionId id) -> Result {
+    Reduction const& reduction = reductions_.at(id);
+    if (workers_.empty()) {
+      Result result = reduction.init;
+      for (; first != last; ++first)
+        result = reduction.reduce(result, **first);
+      return result;
+    }
+
+    Result result = reduction.init;
+    std::string failure;
+    try {
+      std::size_t sent = 0;
+      try {
+        send_shards(first, last, id, sent);
+      } catch (std::system_error const&) {
+        throw;
+      } catch (...) { // an element could not be encoded
+        std::string reply;
+        for (std::size_t k = 0; k < sent; ++k)
+          if (!receive_message(workers_[k].fd, reply))
+            throw std::runtime_error{"jv::ShardedEvaluator: worker exited"};
+        throw;
+      }
+      // every reply is read, even after a failure, to keep the workers in sync
+      std::string reply;
+      for (Worker const& worker : workers_) {
+        if (!receive_message(worker.fd, reply))
+          throw std::runtime_error{"jv::ShardedEvaluator: worker exited"};
+        WireReader in{reply.data(), reply.size()};
+        if (in.read<std::uint8_t>() == 0)
+          result = reduction.merge(result, in.read<Result>());
+        else if (failure.empty())
+          failure = reply.substr(1);
+      }
+    } catch (std::invalid_argument const&) {
+      throw; // unregistered type, the workers are in sync
+    } catch (...) {
+      stop(); // the streams may be out of sync
+      throw;
+    }
+    if (!failure.empty())
+      throw std::runtime_error{"jv::ShardedEvaluator: worker failed: " +
+                               failure};
+    return result;
+  }
+
+  template <typename Container>
+  auto evaluate(Container const& container, ReductionId id) -> Result {
+    using std::begin;
+    using std::end;
+    return evaluate(begin(container), end(container), id);
+  }
+
+private:
+  struct Reduction {
+    Result init;
+    std::function<Result(Result, Base const&)> reduce;
+    std::function<Result(Result, Result)> merge;
+  };
+
+  struct Worker {
+    pid_t pid;
+    int fd;
+  };
+
+  template <typename It>
+  void send_shards(It first, It last, ReductionId id, std::size_t& sent) {
+    auto const n = static_cast<std::size_t>(std::distance(first, last));
+    std::size_t const nb_shards = workers_.size();
+    std::string buffer;
+    for (std::size_t k = 0; k < nb_shards; ++k) {
+      std::size_t const count = n * (k + 1) / nb_shards - n * k / nb_shards;
+      buffer.clear();
+      WireWriter out{buffer};
+      out.write(id);
+      out.write(std::uint64_t{count});
+      for (std::size_t i = 0; i < count; ++i, ++first)
+        registry_.encode(**first, buffer);
+      send_message(workers_[k].fd, buffer);
+      ++sent;
+    }
+  }
+
+  [[noreturn]] static void throw_errno(char const* what) {
+    throw std::system_error{errno, std::generic_category(), what};
+  }
+
+  // Messages are a 64-bit size followed by the bytes.
+  static void send_message(int fd, std::string const& message) {
+    auto const size = static_cast<std::uint64_t>(message.size());
+    write_all(fd, &size, sizeof(size));
+    write_all(fd, message.data(), message.size());
+  }
+
+  // Returns `false` on a clean end of stream.
+  static auto receive_message(int fd, std::string& message) -> bool {
+    std::uint64_t size;
+    if (!read_all(fd, &size, sizeof(size), true))
+      return false;
+    message.resize(size);
+    read_all(fd, &message[0], size, false);
+    return true;
+  }
+
+  static void write_all(int fd, void const* data, std::size_t size) {
+#ifdef MSG_NOSIGNAL
+    constexpr int Flags = MSG_NOSIGNAL; // a dead peer is an error, not a signal
+#else
+    constexpr int Flags = 0;
+#endif
+    auto const* bytes = static_cast<char const*>(data);
+    while (size > 0) {
+      ssize_t const written = ::send(fd, bytes, size, Flags);
+      if (written < 0) {
+        if (errno == EINTR)
+          continue;
+        throw_errno("send");
+      }
+      bytes += written;
+      size -= static_cast<std::size_t>(written);
+    }
+  }
+
+  static auto read_all(int fd, void* data, std::size_t size, bool eof_ok)
+      -> bool {
+    auto* bytes = static_cast<char*>(data);
+    std::size_t done = 0;
+    while (done < size) {
+      ssize_t const got = ::recv(fd, bytes + done, size - done, 0);
+      if (got < 0) {
+        if (errno == EINTR)
+          continue;
+        throw_errno("recv");
+      }
+      if (got == 0) {
+        if (eof_ok && done == 0)
+          return false;
+        throw std::runtime_error{"jv::ShardedEvaluator: truncated message"};
+      }
+      done += static_cast<std::size_t>(got);
+    }
+    return true;
+  }
+
+  // Worker loop: decodes and reduces each shard, without storing it.
+  void serve(int fd) noexcept {
+    try {
+      std::string message, reply;
+      while (receive_message(fd, message)) {
+        reply.clear();
+        WireWriter out{reply};
+        try {
+          WireReader in{message.data(), message.size()};
+          Reduction const& reduction =
+              reductions_.at(in.read<ReductionId>());
+          auto const count = in.read<std::uint64_t>();
+          Result result = reduction.init;
+          for (std::uint64_t i = 0; i < count; ++i) {
+            Poly const value = registry_.decode(in);
+            result = reduction.reduce(result, *value);
+          }
+          out.write(std::uint8_t{0});
+          out.write(result);
+        } catch (std::exception const& e) {
+          reply.clear();
+          out.write(std::uint8_t{1});
+          reply += e.what();
+        }
+        send_message(fd, reply);
+      }
+    } catch (...) {
+      // the parent sees the socket close
+    }
+    ::close(fd);
+  }
+
+  WireRegistry<Poly> registry_;
+  std::vector<Reduction> reductions_;
+  std::vector<Worker> workers_;
+};
+
+} // namespace jv
+
+#endif
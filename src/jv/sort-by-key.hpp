@@ -0,0 +1,167 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_SORT_BY_KEY_HPP
+#define JVERNAY_UTILS_SORT_BY_KEY_HPP
+
+#include <jv/uninitialized.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jv {
+
+namespace details {
+
+template <typename Key>
+constexpr bool is_radix_key_v = (std::is_integral_v<Key> ||
+                                 std::is_enum_v<Key>) &&
+                                !std::is_same_v<Key, bool>;
+
+// Maps an integer key to an unsigned one with the same order.
+template <typename Key> auto radix_bits(Key key) noexcept {
+  using Int = std::conditional_t<std::is_enum_v<Key>,
+                                 std::underlying_type<Key>,
+                                 std::common_type<Key>>;
+  using Unsigned = std::make_unsigned_t<typename Int::type>;
+  auto bits = static_cast<Unsigned>(key);
+  if constexpr (std::is_signed_v<typename Int::type>)
+    bits ^= Unsigned{1} << (8 * sizeof(Unsigned) - 1);
+  return bits;
+}
+
+// Stable LSD radix sort of the positions by key, 11 bits per pass so that
+// 32-bit keys take 3 passes. Passes where every key has the same digit are
+// skipped. Positions are 32-bit when possible, to move less memory.
+template <typename Index, typename Key>
+auto radix_order_with(std::vector<Key> const& keys)
+    -> std::vector<std::size_t> {
+  using Bits = decltype(radix_bits(std::declval<Key>()));
+  constexpr unsigned DigitBits = 11;
+  constexpr std::size_t Radix = std::size_t{1} << DigitBits;
+  struct Entry {
+    Bits bits;
+    Index position;
+  };
+  std::size_t const n = keys.size();
+  std::vector<Entry> entries(n), buffer(n);
+  for (std::size_t i = 0; i < n; ++i)
+    entries[i] = Entry{radix_bits(keys[i]), static_cast<Index>(i)};
+
+  std::vector<std::size_t> counts(Radix);
+  for (unsigned shift = 0; shift < 8 * sizeof(Bits); shift += DigitBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    for (Entry const& entry : entries)
+      ++counts[(entry.bits >> shift) & (Radix - 1)];
+    if (std::find(counts.begin(), counts.end(), n) != counts.end())
+      continue;
+    std::size_t offset = 0;
+    for (std::size_t& count : counts)
+      offset += std::exchange(count, offset);
+    for (Entry const& entry : entries)
+      buffer[counts[(entry.bits >> shift) & (Radix - 1)]++] = entry;
+    entries.swap(buffer);
+  }
+
+  std::vector<std::size_t> order(n);
+  for (std::size_t i = 0; i < n; ++i)
+    order[i] = entries[i].position;
+  return order;
+}
+
+template <typename Key>
+auto radix_order(std::vector<Key> const& keys) -> std::vector<std::size_t> {
+  if (keys.size() <= std::numeric_limits<std::uint32_t>::max())
+    return radix_order_with<std::uint32_t>(keys);
+  return radix_order_with<std::size_t>(keys);
+}
+
+template <typename Key>
+auto comparison_order(std::vector<Key> const& keys)
+    -> std::vector<std::size_t> {
+  std::vector<std::size_t> order(keys.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return keys[a] < keys[b];
+                   });
+  return order;
+}
+
+} // namespace details
+
+/// apply_permutation
+
+/// Reorders `[first, first + order.size())` so that the element at position
+/// `i` is the one which was at position `order[i]`, following the cycles of
+/// the permutation: each misplaced element is relocated once, plus one
+/// relocation through a temporary per cycle. `order` is left as the identity.
+template <typename RandomIt>
+void apply_permutation(RandomIt first,
+                       std::vector<std::size_t>& order) noexcept {
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+
+  std::aligned_storage_t<sizeof(T), alignof(T)> tmp;
+  T* const hole = reinterpret_cast<T*>(&tmp);
+  for (std::size_t start = 0; start < order.size(); ++start) {
+    if (order[start] == start)
+      continue;
+    relocate_at(std::addressof(first[start]), hole);
+    std::size_t i = start;
+    while (order[i] != start) {
+      std::size_t const next = order[i];
+      relocate_at(std::addressof(first[next]), std::addressof(first[i]));
+      order[i] = i;
+      i = next;
+    }
+    relocate_at(hole, std::addressof(first[i]));
+    order[i] = i;
+  }
+}
+
+/// sort_by_key
+
+/// Stable sort of `container` by `key_fn(element)`, which must return a value
+/// comparable with `<`. The keys are extracted once into a compact array and
+/// sorted along with the positions of the elements (with a radix sort for
+/// integer and enumeration keys), then the elements are relocated at most
+/// once each by `apply_permutation`. This is much cheaper than `std::sort`
+/// when moving an element costs more than comparing keys, as for
+/// `BoundedPoly`.
+template <typename Container, typename KeyFn>
+void sort_by_key(Container& container, KeyFn&& key_fn) {
+  using std::begin;
+  using std::end;
+  auto first = begin(container);
+  auto const n = static_cast<std::size_t>(end(container) - first);
+  using Key = std::decay_t<decltype(key_fn(*first))>;
+
+  std::vector<Key> keys;
+  keys.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    keys.push_back(key_fn(first[i]));
+
+  std::vector<std::size_t> order;
+  if constexpr (details::is_radix_key_v<Key>)
+    order = details::radix_order(keys);
+  else
+    order = details::comparison_order(keys);
+  apply_permutation(first, order);
+}
+
+} // namespace jv
+
+#endif
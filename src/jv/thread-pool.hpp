@@ -0,0 +1,162 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_THREAD_POOL_HPP
+#define JVERNAY_UTILS_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jv {
+
+/// Fixed set of worker threads running `parallel_for` loops.
+///
+/// The calling thread takes part in the loop, so a pool of `n` workers runs
+/// on `n + 1` threads, and a pool without workers runs loops sequentially.
+/// Loops never allocate: the body is passed by reference to the workers.
+/// A loop started while another one runs, such as from its body, runs inline
+/// on the calling thread: waiting for the workers would deadlock.
+class ThreadPool {
+public:
+  /// CONSTRUCTORS
+
+  explicit ThreadPool(std::size_t nb_workers) {
+    workers_.reserve(nb_workers);
+    for (std::size_t i = 0; i < nb_workers; ++i)
+      workers_.emplace_back([this] { work(); });
+  }
+
+  ThreadPool(ThreadPool const&) = delete;
+  auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+  /// DESTRUCTOR
+
+  ~ThreadPool() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    start_.notify_all();
+    for (auto& worker : workers_)
+      worker.join();
+  }
+
+  /// size
+
+  /// Number of threads running a loop, the calling one included.
+  auto size() const noexcept -> std::size_t { return workers_.size() + 1; }
+
+  /// parallel_for
+
+  /// Calls `f(first, last)` on chunks of at most `grain` indices covering
+  /// `[begin, end)`, and returns once every chunk is done. If a call throws,
+  /// the remaining chunks are skipped and the first exception is rethrown.
+  template <typename F>
+  void parallel_for(std::size_t begin, std::size_t end, std::size_t grain,
+                    F&& f) {
+    if (begin >= end)
+      return;
+    grain = std::max<std::size_t>(grain, 1);
+    if (workers_.empty() || end - begin <= grain ||
+        busy_.exchange(true, std::memory_order_acquire)) {
+      for (std::size_t first = begin; first < end; first += grain)
+        f(first, std::min(end, first + grain));
+      return;
+    }
+    struct Release { // one loop at a time
+      std::atomic<bool>& busy;
+      ~Release() { busy.store(false, std::memory_order_release); }
+    } const release{busy_};
+
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      job_ = Job{const_cast<void*>(static_cast<void const*>(&f)),
+                 &call<std::remove_reference_t<F>>, end, grain};
+      next_.store(begin, std::memory_order_relaxed);
+      error_ = nullptr;
+      running_ = workers_.size();
+      ++generation_;
+    }
+    start_.notify_all();
+    run_chunks();
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_.wait(lock, [this] { return running_ == 0; });
+    if (error_)
+      std::rethrow_exception(error_);
+  }
+
+private:
+  struct Job {
+    void* body;
+    void (*call)(void*, std::size_t, std::size_t);
+    std::size_t end;
+    std::size_t grain;
+  };
+
+  template <typename F>
+  static void call(void* body, std::size_t first, std::size_t last) {
+    (*static_cast<F*>(body))(first, last);
+  }
+
+  void run_chunks() noexcept {
+    for (;;) {
+      std::size_t const first =
+          next_.fetch_add(job_.grain, std::memory_order_relaxed);
+      if (first >= job_.end)
+        return;
+      try {
+        job_.call(job_.body, first, std::min(job_.end, first + job_.grain));
+      } catch (...) {
+        next_.store(job_.end, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!error_)
+          error_ = std::current_exception();
+      }
+    }
+  }
+
+  void work() {
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock{mutex_};
+    for (;;) {
+      start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+      if (stopping_)
+        return;
+      seen = generation_;
+      lock.unlock();
+      run_chunks();
+      lock.lock();
+      if (--running_ == 0)
+        done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::atomic<bool> busy_{false}; // a loop is running
+
+  std::mutex mutex_; // protects everything below, except `next_`
+  std::condition_variable start_;
+  std::condition_variable done_;
+  Job job_{};
+  std::atomic<std::size_t> next_{0};
+  std::exception_ptr error_;
+  std::size_t running_ = 0;
+  std::uint64_t generation_ = 0;
+  bool stopping_ = false;
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,179 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_UNINITIALIZED_HPP
+#define JVERNAY_UTILS_UNINITIALIZED_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jv {
+
+//======== CONCEPTS =========/
+
+/// Type trait to check if `T` can be relocated with `memcpy`, which is the
+/// case of trivially copyable types. Specialize it for other types, such as
+/// a `BoundedPoly` whose stored types have no pointer to themselves.
+template <typename T> struct is_trivially_relocatable {
+  static constexpr bool value = std::is_trivially_copyable_v<T>;
+};
+
+/// Helper alias for `is_trivially_relocatable`.
+template <typename T>
+constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+namespace details {
+
+// Whether T tells how many of its leading bytes are in use, as BoundedPoly
+// does with `live_size()`. Only that prefix is copied when relocating.
+template <typename T, typename = void>
+struct has_live_size : std::false_type {};
+
+template <typename T>
+struct has_live_size<
+    T, std::void_t<decltype(std::declval<T const&>().live_size())>>
+    : std::true_type {};
+
+// Whether T can be handled by runs of elements of a same dynamic type, as
+// BoundedPoly does with a UniversalMover: see `BoundedPoly::run_length`.
+template <typename T, typename = void> struct has_runs : std::false_type {};
+
+template <typename T>
+struct has_runs<T, std::void_t<decltype(T::run_length(
+                       std::declval<T const*>(), std::declval<T const*>()))>>
+    : std::true_type {};
+
+} // namespace details
+
+//======== ALGORITHMS =========/
+
+/// relocate_at
+
+/// Moves `*src` to the uninitialized `dst`, then destroys `*src`. Trivially
+/// relocatable types providing `live_size()` copy only that many bytes.
+template <typename T> void relocate_at(T* src, T* dst) noexcept {
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+  if constexpr (is_trivially_relocatable_v<T> &&
+                details::has_live_size<T>::value) {
+    std::memcpy(static_cast<void*>(dst), static_cast<void const*>(src),
+                src->live_size());
+  } else if constexpr (is_trivially_relocatable_v<T>) {
+    std::memcpy(static_cast<void*>(dst), static_cast<void const*>(src),
+                sizeof(T));
+  } else {
+    new (dst) T(std::move(*src));
+    src->~T();
+  }
+}
+
+namespace details {
+
+// Relocates to a destination which does not overlap the source, run by run.
+template <typename T> void relocate_runs(T* first, T* last, T* dest) noexcept {
+  if constexpr (has_runs<T>::value) {
+    while (first != last) {
+      std::size_t const n = T::run_length(first, last);
+      if (n == 1) // cheaper alone
+        relocate_at(first, dest);
+      else
+        T::relocate_run(first, n, dest);
+      first += n;
+      dest += n;
+    }
+  }
+}
+
+} // namespace details
+
+/// uninitialized_relocate
+
+/// Relocates `[first, last)` to `[dest, dest + (last - first))`, leaving the
+/// source uninitialized. The ranges may overlap, which is what insertion and
+/// erasure need. Returns the end of the destination.
+///
+/// Trivially relocatable types are moved with a single `memmove`, unless they
+/// provide `live_size()`: then each element copies its live prefix only.
+/// Otherwise, if the ranges do not overlap, as when growing a vector, types
+/// handled by runs (see `BoundedPoly::run_length`) make one indirect call
+/// per run of elements storing the same type.
+template <typename T>
+auto uninitialized_relocate(T* first, T* last, T* dest) noexcept -> T* {
+  static_assert(std::is_nothrow_move_constructible_v<T>);
+  std::size_t const n = static_cast<std::size_t>(last - first);
+  if constexpr (is_trivially_relocatable_v<T> &&
+                !details::has_live_size<T>::value) {
+    if (n != 0)
+      std::memmove(static_cast<void*>(dest), static_cast<void const*>(first),
+                   n * sizeof(T));
+  } else if (dest == first) {
+    // nothing to do
+  } else if (details::has_runs<T>::value &&
+             (dest + n <= first || dest >= last)) {
+    details::relocate_runs(first, last, dest);
+  } else if (dest < first || dest >= last) {
+    for (std::size_t i = 0; i < n; ++i)
+      relocate_at(first + i, dest + i);
+  } else { // overlapping, towards the end
+    for (std::size_t i = n; i-- > 0;)
+      relocate_at(first + i, dest + i);
+  }
+  return dest + n;
+}
+
+/// uninitialized_relocate_n
+
+template <typename T>
+auto uninitialized_relocate_n(T* first, std::size_t n, T* dest) noexcept
+    -> T* {
+  return uninitialized_relocate(first, first + n, dest);
+}
+
+/// destroy
+
+/// Destroys `[first, last)`, in order, run by run for types handled by runs.
+template <typename T> void destroy(T* first, T* last) noexcept {
+  static_assert(std::is_nothrow_destructible_v<T>);
+  if constexpr (details::has_runs<T>::value) {
+    while (first != last) {
+      std::size_t const n = T::run_length(first, last);
+      if (n == 1)
+        first->~T();
+      else
+        T::destroy_run(first, n);
+      first += n;
+    }
+  } else if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (; first != last; ++first)
+      first->~T();
+  }
+}
+
+/// uninitialized_move_if_noexcept
+
+/// Constructs `[dest, dest + (last - first))` from `[first, last)`, moving
+/// if it cannot throw and copying otherwise, as `std::vector` does. If a copy
+/// throws, the constructed values are destroyed, and the source is unchanged.
+/// Returns the end of the destination.
+template <typename T>
+auto uninitialized_move_if_noexcept(T* first, T* last, T* dest) -> T* {
+  T* current = dest;
+  try {
+    for (; first != last; ++first, ++current)
+      new (current) T(std::move_if_noexcept(*first));
+  } catch (...) {
+    jv::destroy(dest, current);
+    throw;
+  }
+  return current;
+}
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,182 @@
+
+//          Copyright Julien Vernay 2020.
+// Distributed under the Boost Software License, Version 1.0.
+//        (See accompanying file LICENSE or copy at
+//          https://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef JVERNAY_UTILS_VTABLE_MOVER_HPP
+#define JVERNAY_UTILS_VTABLE_MOVER_HPP
+
+#include <jv/bounded-poly.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jv {
+
+namespace details {
+
+// The vtable pointer of a polymorphic object: its first word, with the
+// usual ABIs, as long as the class has no virtual base.
+inline auto vtable_of(void const* object) noexcept -> void const* {
+  void const* vtable;
+  std::memcpy(&vtable, object, sizeof(vtable));
+  return vtable;
+}
+
+// Map from the vtable of every type moved as a T to its move function.
+//
+// Registering never allocates, so that it can be done by the noexcept
+// members of `BoundedPoly`: each type brings its own node, in static
+// storage, pushed on a lock-free list. The list is then copied into a hash
+// table for the lookups. If that copy fails, lookups missing from the table
+// scan the list. Lookups are lock-free: a table is immutable once published,
+// and is kept, as lookups may still read it. The registry itself is never
+// destroyed, so that objects can be moved during static destruction.
+template <typename T> class VtableRegistry {
+public:
+  using Move = void (*)(T&& src, void* dst) noexcept;
+
+  struct Node {
+    void const* vtable;
+    Move move;
+    Node const* next = nullptr;
+  };
+
+  static auto instance() noexcept -> VtableRegistry& {
+    alignas(VtableRegistry) static unsigned char buffer[sizeof(VtableRegistry)];
+    static auto* registry = new (buffer) VtableRegistry;
+    return *registry;
+  }
+
+  void add(Node& node) noexcept {
+    node.next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(node.next, &node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+    try {
+      rebuild();
+    } catch (...) { // lookups of this type scan the list
+    }
+  }
+
+  auto find(void const* vtable) const noexcept -> Move {
+    if (Table const* table = table_.load(std::memory_order_acquire)) {
+      for (std::size_t i = table->slot(vtable);; i = (i + 1) & table->mask) {
+        Entry const& entry = table->entries[i];
+        if (entry.vtable == vtable)
+          return entry.move;
+        if (entry.vtable == nullptr)
+          break;
+      }
+    }
+    for (Node const* node = head_.load(std::memory_order_acquire);
+         node != nullptr; node = node->next)
+      if (node->vtable == vtable)
+        return node->move;
+    std::terminate(); // not constructed through BoundedPoly
+  }
+
+private:
+  struct Entry {
+    void const* vtable = nullptr;
+    Move move = nullptr;
+  };
+
+  // Open addressing with linear probing.
+  struct Table {
+    std::size_t capacity, mask;
+    std::unique_ptr<Entry[]> entries;
+
+    explicit Table(std::size_t capacity_)
+        : capacity{capacity_}, mask{capacity_ - 1},
+          entries{new Entry[capacity_]} {}
+
+    auto slot(void const* vtable) const noexcept -> std::size_t {
+      auto const key = reinterpret_cast<std::uintptr_t>(vtable);
+      return static_cast<std::size_t>((key >> 3) * 0x9E3779B97F4A7C15ull >>
+                                      32) &
+             mask;
+    }
+
+    void insert(Entry entry) noexcept {
+      std::size_t i = slot(entry.vtable);
+      while (entries[i].vtable != nullptr)
+        i = (i + 1) & mask;
+      entries[i] = entry;
+    }
+  };
+
+  VtableRegistry() noexcept = default;
+
+  // Publishes a table of every node, at a load factor of at most 1/2.
+  void rebuild() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    Node const* const head = head_.load(std::memory_order_acquire);
+    std::size_t size = 0;
+    for (Node const* node = head; node != nullptr; node = node->next)
+      ++size;
+    std::size_t capacity = 16;
+    while (2 * size > capacity)
+      capacity *= 2;
+    auto table = std::make_unique<Table>(capacity);
+    for (Node const* node = head; node != nullptr; node = node->next)
+      table->insert(Entry{node->vtable, node->move});
+    tables_.reserve(tables_.size() + 1); // nothing throws once published
+    table_.store(table.get(), std::memory_order_release);
+    tables_.push_back(std::move(table));
+  }
+
+  std::atomic<Node const*> head_{nullptr};
+  std::mutex mutex_;
+  std::atomic<Table const*> table_{nullptr};
+  std::vector<std::unique_ptr<Table>> tables_;
+};
+
+} // namespace details
+
+/// A stateless mover which finds how to move an object from its vtable.
+///
+/// `BoundedPoly` registers each type the first time it stores one, mapping
+/// its vtable to its move function. Moves then look the vtable up, first in
+/// a one-entry cache per thread. So a `BoundedPoly` using it is as small as
+/// `Storage`, like with `VirtualMover`, but the stored types need no
+/// `move_to` method.
+///
+/// Objects must be moved by the same module (executable or shared library)
+/// which stored them, and `T` must have no virtual base.
+template <typename T> class VtableMover {
+  using Registry = details::VtableRegistry<T>;
+
+public:
+  /// Called by `BoundedPoly` each time it stores an `A`. Never allocates.
+  template <typename A> static void register_type(T const& value) noexcept {
+    static typename Registry::Node node{details::vtable_of(&value),
+                                        &details::universal_move<T, A>};
+    static bool const registered = (Registry::instance().add(node), true);
+    (void)registered;
+  }
+
+  void operator()(T&& src, void* dst) const noexcept {
+    struct Cache {
+      void const* vtable = nullptr;
+      typename Registry::Move move = nullptr;
+    };
+    static thread_local Cache cache;
+    void const* vtable = details::vtable_of(&src);
+    if (cache.vtable != vtable)
+      cache = Cache{vtable, Registry::instance().find(vtable)};
+    cache.move(std::move(src), dst);
+  }
+};
+
+} // namespace jv
+
+#endif
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include <jv/actor-system.hpp>
+#include <jv/bounded-poly.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+struct IMessage {
+    virtual ~IMessage() noexcept {}
+    virtual auto value() const noexcept -> int = 0;
+};
+
+struct Ping : IMessage {
+    int hops;
+    Ping(int h) noexcept : hops(h) {}
+    auto value() const noexcept -> int override { return hops; }
+};
+
+struct IActor {
+    virtual ~IActor() noexcept {}
+    virtual void receive(IMessage& message) noexcept = 0;
+};
+
+using Message = jv::BoundedPoly<std::aligned_union_t<0, Ping>, IMessage>;
+using Actor = jv::BoundedPoly<std::aligned_storage_t<32>, IActor>;
+using System = jv::ActorSystem<Actor, Message, 8, 4>;
+
+struct Counter : IActor {
+    std::atomic<int>* received;
+    std::atomic<long>* sum;
+    Counter(std::atomic<int>& r, std::atomic<long>& s) noexcept
+        : received(&r), sum(&s) {}
+    void receive(IMessage& message) noexcept override {
+        *sum += message.value();
+        ++*received;
+    }
+};
+
+// Sends the ping back to `peer` until it has no hop left.
+struct Bouncer : IActor {
+    System* system;
+    System::ActorId peer;
+    std::atomic<int>* finished;
+    Bouncer(System& s, System::ActorId p, std::atomic<int>& f) noexcept
+        : system(&s), peer(p), finished(&f) {}
+    void receive(IMessage& message) noexcept override {
+        if (message.value() == 0)
+            ++*finished;
+        else
+            while (!system->try_send(peer, Ping{message.value() - 1}))
+                std::this_thread::yield();
+    }
+};
+
+struct Failing : IActor {
+    Failing() { throw std::runtime_error{"cannot start"}; }
+    void receive(IMessage&) noexcept override {}
+};
+
+template <typename Predicate> auto wait_for(Predicate&& predicate) -> bool {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{20};
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("ActorSystem without workers", "[utils][bounded-poly][ActorSystem]") {
+    std::atomic<int> received{0};
+    std::atomic<long> sum{0};
+    System system{4};
+
+    auto counter = system.spawn(std::in_place_type_t<Counter>{}, received, sum);
+    for (int i = 1; i <= 8; ++i)
+        REQUIRE(system.try_send(counter, Ping{i}));
+    CHECK(!system.try_send(counter, Ping{100})); // the mailbox is full
+    // not spawned yet, and out of the pool
+    CHECK_THROWS_AS(system.try_send(counter + 1, Ping{1}), std::out_of_range);
+    CHECK_THROWS_AS(system.try_send(99, Ping{1}), std::out_of_range);
+    CHECK(received == 0);
+
+    CHECK(system.run_pending() == 8);
+    CHECK(received == 8);
+    CHECK(sum == 36);
+    CHECK(system.run_pending() == 0);
+
+    std::atomic<int> finished{0};
+    auto a = system.spawn(std::in_place_type_t<Bouncer>{}, system, 0, finished);
+    auto b = system.spawn(std::in_place_type_t<Bouncer>{}, system, a, finished);
+    system.actor(a) = Bouncer{system, b, finished}; // now they know each other
+    REQUIRE(system.try_send(a, Ping{11}));
+    CHECK(system.run_pending() == 12);
+    CHECK(finished == 1);
+
+    system.spawn(std::in_place_type_t<Counter>{}, received, sum);
+    CHECK_THROWS_AS(
+        system.spawn(std::in_place_type_t<Counter>{}, received, sum),
+        std::length_error);
+}
+
+TEST_CASE("ActorSystem with workers", "[utils][bounded-poly][ActorSystem]") {
+    constexpr int NbPairs = 16;
+    constexpr int Hops = 200;
+
+    std::atomic<int> finished{0};
+    std::atomic<int> received{0};
+    std::atomic<long> sum{0};
+    System system{2 * NbPairs + 1};
+
+    for (int i = 0; i < NbPairs; ++i) {
+        auto a =
+            system.spawn(std::in_place_type_t<Bouncer>{}, system, 0, finished);
+        auto b =
+            system.spawn(std::in_place_type_t<Bouncer>{}, system, a, finished);
+        system.actor(a) = Bouncer{system, b, finished};
+    }
+    auto counter = system.spawn(std::in_place_type_t<Counter>{}, received, sum);
+
+    system.start(4);
+    for (System::ActorId a = 0; a < 2 * NbPairs; a += 2)
+        REQUIRE(system.try_send(a, Ping{Hops}));
+    for (int i = 0; i < 1000; ++i)
+        while (!system.try_send(counter, Ping{1}))
+            std::this_thread::yield();
+
+    CHECK(wait_for([&] { return finished == NbPairs && received == 1000; }));
+    system.stop();
+    CHECK(sum == 1000);
+}
+
+TEST_CASE("ActorSystem when an actor constructor throws",
+          "[utils][bounded-poly][ActorSystem]") {
+    std::atomic<int> received{0};
+    std::atomic<long> sum{0};
+    {
+        System system{2};
+        CHECK_THROWS_AS(system.spawn(std::in_place_type_t<Failing>{}),
+                        std::runtime_error);
+        // the slot was given back, and is not reachable meanwhile
+        CHECK_THROWS_AS(system.try_send(0, Ping{1}), std::out_of_range);
+        auto counter =
+            system.spawn(std::in_place_type_t<Counter>{}, received, sum);
+        CHECK(counter == 0);
+        REQUIRE(system.try_send(counter, Ping{5}));
+        CHECK(system.run_pending() == 1);
+        CHECK(sum == 5);
+        // the destructor only destroys constructed actors
+    }
+}
@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <jv/adaptive-filter-chain.hpp>
+
+#include <type_traits>
+
+namespace {
+
+// Accepts everything, slowly.
+struct Slow final : jv::IFilter<int> {
+    void move_to(void* dst) && noexcept override {
+        new (dst) Slow(std::move(*this));
+    }
+    auto accept(int const& x) const -> bool override {
+        volatile int sink = x;
+        for (int i = 0; i < 500; ++i)
+            sink = sink + i;
+        return true;
+    }
+};
+
+// Accepts multiples of `divisor`, quickly.
+struct MultipleOf final : jv::IFilter<int> {
+    int divisor;
+    MultipleOf(int d) noexcept : divisor(d) {}
+    void move_to(void* dst) && noexcept override {
+        new (dst) MultipleOf(std::move(*this));
+    }
+    auto accept(int const& x) const -> bool override {
+        return x % divisor == 0;
+    }
+};
+
+// Fails the test if it sees an odd record, which its guard keeps out.
+struct NeedsEven final : jv::IFilter<int> {
+    int* violations;
+    NeedsEven(int& v) noexcept : violations(&v) {}
+    void move_to(void* dst) && noexcept override {
+        new (dst) NeedsEven(std::move(*this));
+    }
+    auto accept(int const& x) const -> bool override {
+        *violations += x % 2 != 0;
+        return true;
+    }
+};
+
+using Chain = jv::AdaptiveFilterChain<int, std::aligned_storage_t<16>>;
+
+auto is_slow(Chain const& chain, std::size_t i) -> bool {
+    return dynamic_cast<Slow const*>(&*chain[i]) != nullptr;
+}
+
+} // namespace
+
+TEST_CASE("AdaptiveFilterChain reorders free filters",
+          "[utils][bounded-poly][AdaptiveFilterChain]") {
+    Chain chain{1, 1000};
+    chain.add(Slow{});
+    chain.emplace<MultipleOf>(jv::FilterOrder::Free, 10);
+    REQUIRE(chain.size() == 2);
+    CHECK(is_slow(chain, 0));
+
+    int accepted = 0;
+    for (int x = 0; x < 2000; ++x)
+        accepted += chain.accept(x);
+    CHECK(accepted == 200);
+    // the cheap and selective filter now runs first
+    CHECK(!is_slow(chain, 0));
+    CHECK(is_slow(chain, 1));
+}
+
+TEST_CASE("AdaptiveFilterChain keeps fixed filters in place",
+          "[utils][bounded-poly][AdaptiveFilterChain]") {
+    Chain chain{1, 1000};
+    chain.add(Slow{});
+    chain.add(MultipleOf{2}, jv::FilterOrder::Fixed);
+    chain.add(Slow{});
+    chain.add(MultipleOf{5});
+
+    int accepted = 0;
+    for (int x = 0; x < 2000; ++x)
+        accepted += chain.accept(x);
+    CHECK(accepted == 200);
+    CHECK(is_slow(chain, 0)); // alone before the barrier
+    CHECK(!is_slow(chain, 1));
+    CHECK(static_cast<MultipleOf const&>(*chain[1]).divisor == 2);
+    CHECK(!is_slow(chain, 2));
+    CHECK(static_cast<MultipleOf const&>(*chain[2]).divisor == 5);
+    CHECK(is_slow(chain, 3));
+}
+
+TEST_CASE("AdaptiveFilterChain never runs a filter past a rejecting guard",
+          "[utils][bounded-poly][AdaptiveFilterChain]") {
+    int violations = 0;
+    Chain chain{1, 1000}; // every record is sampled
+    chain.add(MultipleOf{3});
+    chain.add(MultipleOf{2}, jv::FilterOrder::Fixed); // the guard
+    chain.emplace<NeedsEven>(jv::FilterOrder::Free, violations);
+    chain.add(Slow{});
+
+    int accepted = 0;
+    for (int x = 0; x < 600; ++x)
+        accepted += chain.accept(x);
+    CHECK(accepted == 100);
+    CHECK(violations == 0);
+}
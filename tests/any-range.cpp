@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <jv/any-range.hpp>
+
+#include <list>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// minimal forward iterator, which cannot be decremented
+struct Forward {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = int const*;
+    using reference = int const&;
+    int const* p;
+    auto operator*() const -> int const& { return *p; }
+    auto operator++() -> Forward& { return ++p, *this; }
+    auto operator==(Forward const& o) const -> bool { return p == o.p; }
+};
+
+} // namespace
+
+TEST_CASE("AnyIterator", "[utils][bounded-poly][AnyIterator]") {
+    using Iterator = jv::AnyIterator<int, std::bidirectional_iterator_tag>;
+
+    std::vector<int> vec{1, 2, 3};
+    std::list<int> list{4, 5, 6};
+
+    Iterator it = vec.begin();
+    CHECK(*it == 1);
+    CHECK(*++it == 2);
+    CHECK(*it++ == 2);
+    CHECK(*it == 3);
+    CHECK(*--it == 2);
+
+    Iterator copy = it; // copies the erased iterator
+    ++copy;
+    CHECK(*it == 2);
+    CHECK(*copy == 3);
+    CHECK(++copy == Iterator{vec.end()});
+
+    it = Iterator{list.begin()}; // the erased type can change
+    *it = 40;
+    CHECK(list.front() == 40);
+
+    int sum = 0;
+    for (Iterator i = list.begin(), end = list.end(); i != end; ++i)
+        sum += *i;
+    CHECK(sum == 40 + 5 + 6);
+
+    // a forward AnyIterator does not need bidirectional iterators
+    jv::AnyIterator<int const> forward = Forward{vec.data()};
+    CHECK(*++forward == 2);
+
+    // default-constructed iterators are singular, but equal to each other
+    static_assert(std::is_nothrow_default_constructible_v<Iterator>);
+    Iterator singular, other;
+    CHECK(singular == other);
+    CHECK(Iterator{singular} == other);
+    singular = vec.begin();
+    CHECK(*singular == 1);
+}
+
+TEST_CASE("AnyRange", "[utils][bounded-poly][AnyRange]") {
+    std::vector<int> vec(1000);
+    std::iota(vec.begin(), vec.end(), 0);
+    std::list<int> list(vec.begin(), vec.end());
+
+    SECTION("iterators") {
+        jv::AnyRange<int> range = list;
+        int expected = 0;
+        for (int& i : range)
+            CHECK(i == expected++);
+        CHECK(expected == 1000);
+    }
+
+    SECTION("batches") {
+        jv::AnyRange<int> range{vec.begin() + 10, vec.end()};
+        int* batch[64];
+        std::size_t n = range.next_batch(batch, 64);
+        REQUIRE(n == 64);
+        CHECK(*batch[0] == 10);
+        CHECK(batch[63] == &vec[73]);
+        CHECK(*range.begin() == 74); // the batch was consumed
+
+        long sum = 0;
+        range.for_each([&](int& i) { sum += i; });
+        CHECK(sum == std::accumulate(vec.begin() + 74, vec.end(), 0L));
+        CHECK(range.empty());
+        CHECK(range.next_batch(batch, 64) == 0);
+    }
+
+    SECTION("const elements") {
+        std::vector<int> const& cvec = vec;
+        jv::AnyRange<int const> range = cvec;
+        long sum = 0;
+        range.for_each<16>([&](int const& i) { sum += i; });
+        CHECK(sum == 999 * 1000 / 2);
+    }
+}
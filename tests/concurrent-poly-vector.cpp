@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/concurrent-poly-vector.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct IRecord {
+    virtual ~IRecord() noexcept {}
+    virtual auto id() const noexcept -> int = 0;
+};
+
+struct Small : IRecord {
+    int value;
+    Small(int v) noexcept : value(v) {}
+    auto id() const noexcept -> int override { return value; }
+};
+
+struct Large : IRecord {
+    int value;
+    int padding[7] = {};
+    Large(int v) noexcept : value(v) {}
+    auto id() const noexcept -> int override { return value; }
+};
+
+struct Counted : IRecord {
+    std::atomic<int>* counter;
+    Counted(std::atomic<int>& c) noexcept : counter(&c) {}
+    Counted(Counted&& other) noexcept : counter(other.counter) {
+        other.counter = nullptr;
+    }
+    ~Counted() noexcept override {
+        if (counter)
+            ++*counter;
+    }
+    auto id() const noexcept -> int override { return -1; }
+};
+
+using Record = jv::BoundedPoly<std::aligned_union_t<0, Small, Large, Counted>,
+                               IRecord>;
+
+} // namespace
+
+TEST_CASE("ConcurrentPolyVector single producer",
+          "[utils][bounded-poly][ConcurrentPolyVector]") {
+    jv::ConcurrentPolyVector<Record, 4> vec; // tiny chunks to cross boundaries
+    REQUIRE(vec.empty());
+
+    for (int i = 0; i < 100; ++i) {
+        std::size_t index =
+            i % 2 ? vec.push_back(Small{i})
+                  : vec.emplace_back(std::in_place_type_t<Large>{}, i);
+        REQUIRE(index == std::size_t(i));
+    }
+    REQUIRE(vec.size() == 100);
+
+    for (int i = 0; i < 100; ++i)
+        CHECK(vec[i]->id() == i);
+
+    int expected = 0;
+    vec.for_each([&](Record const& r) { CHECK(r->id() == expected++); });
+    CHECK(expected == 100);
+}
+
+TEST_CASE("ConcurrentPolyVector destroys its elements",
+          "[utils][bounded-poly][ConcurrentPolyVector]") {
+    std::atomic<int> destroyed{0};
+    {
+        jv::ConcurrentPolyVector<Record, 8> vec;
+        for (int i = 0; i < 20; ++i)
+            vec.emplace_back(std::in_place_type_t<Counted>{}, destroyed);
+        REQUIRE(destroyed == 0);
+    }
+    CHECK(destroyed == 20);
+}
+
+TEST_CASE("ConcurrentPolyVector many producers",
+          "[utils][bounded-poly][ConcurrentPolyVector]") {
+    constexpr int NbProducers = 8;
+    constexpr int PerProducer = 20'000;
+    constexpr int Total = NbProducers * PerProducer;
+
+    jv::ConcurrentPolyVector<Record, 64> vec;
+    std::atomic<bool> done{false};
+    std::atomic<bool> reader_ok{true};
+
+    // the reader checks that the published prefix is always fully constructed
+    std::thread reader([&] {
+        std::size_t seen = 0;
+        while (!done.load() || seen < vec.size()) {
+            std::size_t size = vec.size();
+            if (size < seen)
+                reader_ok = false;
+            for (; seen < size; ++seen)
+                if (vec[seen]->id() < 0 || vec[seen]->id() >= Total)
+                    reader_ok = false;
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < NbProducers; ++p)
+        producers.emplace_back([&vec, p] {
+            for (int i = 0; i < PerProducer; ++i)
+                vec.push_back(Small{p * PerProducer + i});
+        });
+    for (auto& producer : producers)
+        producer.join();
+    done = true;
+    reader.join();
+
+    REQUIRE(reader_ok);
+    REQUIRE(vec.size() == std::size_t(Total));
+
+    std::vector<bool> present(Total, false);
+    vec.for_each([&](Record const& r) { present[r->id()] = true; });
+    int missing = 0;
+    for (int i = 0; i < Total; ++i)
+        missing += !present[i];
+    CHECK(missing == 0);
+}
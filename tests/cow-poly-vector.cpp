@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/cow-poly-vector.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace {
+
+int nb_clones = 0;
+
+struct ICounter;
+using Counter = jv::BoundedPoly<std::aligned_storage_t<32>, ICounter>;
+
+struct ICounter {
+    virtual ~ICounter() noexcept {}
+    virtual auto value() const noexcept -> int = 0;
+    virtual void increment() noexcept = 0;
+    virtual auto clone() const -> Counter = 0;
+};
+
+// Move-only, like many types stored in a BoundedPoly.
+struct Simple final : ICounter {
+    std::unique_ptr<int> count;
+    Simple(int c) : count(std::make_unique<int>(c)) {}
+    auto value() const noexcept -> int override { return *count; }
+    void increment() noexcept override { ++*count; }
+    auto clone() const -> Counter override {
+        ++nb_clones;
+        return Counter{Simple{*count}};
+    }
+};
+
+auto clone_counter(Counter const& counter) -> Counter {
+    return counter->clone();
+}
+
+using Vector = jv::CowPolyVector<Counter, 4>;
+
+} // namespace
+
+TEST_CASE("CowPolyVector snapshots are independent",
+          "[utils][bounded-poly][CowPolyVector]") {
+    Vector vec{&clone_counter};
+    for (int i = 0; i < 10; ++i)
+        vec.emplace_back<Simple>(i);
+    REQUIRE(vec.size() == 10);
+    CHECK(!vec.is_shared(0));
+
+    nb_clones = 0;
+    Vector snapshot = vec.snapshot();
+    CHECK(nb_clones == 0);
+    CHECK(vec.is_shared(0));
+
+    vec.mutate(5)->increment(); // copies the chunk [4, 8) only
+    CHECK(nb_clones == 4);
+    CHECK(vec[5]->value() == 6);
+    CHECK(snapshot[5]->value() == 5);
+    CHECK(vec.is_shared(0));
+    CHECK(!vec.is_shared(5));
+
+    vec.push_back(Simple{10}); // copies the last chunk [8, 10)
+    CHECK(nb_clones == 6);
+    vec.pop_back();
+    vec.pop_back();
+    vec.pop_back(); // drops its last chunk
+    CHECK(vec.size() == 8);
+    CHECK(snapshot.size() == 10);
+    CHECK(nb_clones == 6);
+
+    int sum = 0;
+    snapshot.for_each([&](Counter const& c) { sum += c->value(); });
+    CHECK(sum == 45);
+    sum = 0;
+    vec.for_each([&](Counter const& c) { sum += c->value(); });
+    CHECK(sum == 28 + 1);
+
+    snapshot = Vector{&clone_counter}; // vec owns every chunk again
+    CHECK(!vec.is_shared(0));
+    vec.mutate(0)->increment();
+    CHECK(nb_clones == 6);
+}
+
+TEST_CASE("CowPolyVector snapshot read by another thread",
+          "[utils][bounded-poly][CowPolyVector]") {
+    Vector vec{&clone_counter};
+    for (int i = 0; i < 1000; ++i)
+        vec.emplace_back<Simple>(1);
+
+    for (int round = 0; round < 20; ++round) {
+        Vector snapshot = vec.snapshot();
+        std::atomic<int> sum{0};
+        std::thread reader{[&sum, snap = std::move(snapshot)] {
+            int local = 0;
+            snap.for_each([&](Counter const& c) { local += c->value(); });
+            sum = local;
+        }};
+        for (int i = 0; i < 1000; i += 7)
+            vec.mutate(i)->increment();
+        reader.join();
+        CHECK(sum == 1000 + 143 * round);
+    }
+}
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <jv/dataflow-graph.hpp>
+
+#include <functional>
+
+namespace {
+
+using Graph = jv::DataflowGraph<long>;
+
+// Counts how many times it runs, to check that clean nodes are skipped.
+struct CountingSum final : jv::IDataflowNode<long> {
+    int* runs;
+    CountingSum(int& r) noexcept : runs(&r) {}
+    void move_to(void* dst) && noexcept override {
+        new (dst) CountingSum(std::move(*this));
+    }
+    auto compute(jv::DataflowInputs<long> const& inputs) -> long override {
+        ++*runs;
+        long sum = 0;
+        for (std::size_t i = 0; i < inputs.size(); ++i)
+            sum += inputs[i];
+        return sum;
+    }
+};
+
+} // namespace
+
+TEST_CASE("DataflowGraph incremental recomputation",
+          "[utils][bounded-poly][DataflowGraph]") {
+    int runs = 0;
+    Graph::Builder builder;
+    auto a = builder.source(1);
+    auto b = builder.source(2);
+    auto c = builder.source(3);
+    auto ab = builder.function(std::plus<>{}, a, b);
+    auto sign_c = builder.function([](long x) { return x < 0 ? -1L : 1L; }, c);
+    auto total = builder.add<CountingSum>({ab, sign_c, a}, runs);
+    Graph graph = std::move(builder).build();
+
+    CHECK(graph.recompute() == 3); // everything is dirty at first
+    CHECK(graph.value(total) == 3 + 1 + 1);
+    CHECK(runs == 1);
+    CHECK(graph.recompute() == 0);
+
+    graph.set(b, 10); // ab and total depend on b
+    CHECK(graph.recompute() == 2);
+    CHECK(graph.value(ab) == 11);
+    CHECK(graph.value(total) == 11 + 1 + 1);
+
+    graph.set(c, 4); // sign_c does not change, so total is not recomputed
+    CHECK(graph.recompute() == 1);
+    CHECK(runs == 2);
+
+    graph.set(c, -4);
+    CHECK(graph.recompute() == 2);
+    CHECK(graph.value(total) == 11 - 1 + 1);
+
+    graph.set(a, 1); // same value: nothing is dirty
+    CHECK(graph.recompute() == 0);
+}
+
+TEST_CASE("DataflowGraph parallel recomputation",
+          "[utils][bounded-poly][DataflowGraph]") {
+    constexpr int Width = 500;
+
+    // a wide layer of independent nodes, summed by a chain of reductions
+    Graph::Builder builder;
+    auto x = builder.source(1);
+    std::vector<Graph::NodeId> layer;
+    for (int i = 0; i < Width; ++i)
+        layer.push_back(
+            builder.function([i](long v) { return v * i; }, x));
+    auto sum = layer[0];
+    for (int i = 1; i < Width; ++i)
+        sum = builder.function(std::plus<>{}, sum, layer[i]);
+    Graph graph = std::move(builder).build();
+
+    jv::ThreadPool pool{3};
+    graph.recompute(&pool, 16);
+    CHECK(graph.value(sum) == long(Width) * (Width - 1) / 2);
+
+    graph.set(x, 3);
+    CHECK(graph.recompute(&pool, 16) == std::size_t(2 * Width - 1));
+    CHECK(graph.value(sum) == 3L * Width * (Width - 1) / 2);
+}
+
+TEST_CASE("DataflowGraph of bools, and constant operators",
+          "[utils][bounded-poly][DataflowGraph]") {
+    jv::DataflowGraph<bool>::Builder builder;
+    auto a = builder.source(true);
+    auto yes = builder.function([] { return true; }); // neither a source
+    auto both = builder.function([](bool x, bool y) { return x && y; }, a, yes);
+    auto graph = std::move(builder).build();
+
+    CHECK(graph.recompute() == 2);
+    CHECK(graph.value(yes));
+    CHECK(graph.value(both));
+    CHECK(graph.recompute() == 0); // constants only run once
+
+    graph.set(a, false);
+    CHECK(graph.recompute() == 1);
+    CHECK_FALSE(graph.value(both));
+}
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include <jv/fat-poly.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct IOp {
+    virtual ~IOp() noexcept {}
+    virtual auto apply(int accum) const noexcept -> int = 0;
+    virtual void scale(int factor) = 0;
+    virtual auto name() const -> std::string { return "op"; }
+};
+
+struct Add final : IOp {
+    int rhs;
+    Add(int x) noexcept : rhs(x) {}
+    auto apply(int accum) const noexcept -> int override { return accum + rhs; }
+    void scale(int factor) override { rhs *= factor; }
+    auto name() const -> std::string override { return "add"; }
+};
+
+// not overriding every method
+struct Mul final : IOp {
+    int rhs;
+    Mul(int x) noexcept : rhs(x) {}
+    auto apply(int accum) const noexcept -> int override { return accum * rhs; }
+    void scale(int factor) override { rhs *= factor; }
+};
+
+using Op = jv::FatPoly<std::aligned_union_t<0, Add, Mul>, IOp, &IOp::apply,
+                       &IOp::scale, &IOp::name>;
+
+} // namespace
+
+TEST_CASE("FatPoly cached calls", "[utils][FatPoly]") {
+    static_assert(Op::method_index_v<&IOp::apply> == 0);
+    static_assert(Op::method_index_v<&IOp::name> == 2);
+
+    std::vector<Op> ops;
+    ops.emplace_back(Add{2});
+    ops.emplace_back(std::in_place_type_t<Mul>{}, 3);
+    ops.emplace_back(Add{-1});
+
+    int accum = 1;
+    for (Op const& op : ops)
+        accum = op.call<&IOp::apply>(accum);
+    CHECK(accum == 8);
+
+    ops[1].call<&IOp::scale>(2);
+    CHECK(ops[0].call<&IOp::name>() == "add");
+    CHECK(ops[1].call<&IOp::name>() == "op"); // inherited from IOp
+    CHECK(ops[1]->apply(1) == 6);
+
+    ops[0].emplace<Mul>(10);
+    CHECK(ops[0].call<&IOp::apply>(2) == 20);
+    CHECK(ops[0].call<&IOp::name>() == "op");
+
+    ops[0].swap(ops[2]);
+    CHECK(ops[0].call<&IOp::apply>(2) == 1);
+    CHECK(ops[2].call<&IOp::apply>(2) == 20);
+
+    Op moved{std::move(ops[0])};
+    CHECK(moved.call<&IOp::name>() == "add");
+    ops[0] = std::move(ops[1]);
+    CHECK(ops[0].call<&IOp::apply>(1) == 6);
+}
@@ -0,0 +1,136 @@
+#include "catch.hpp"
+
+#include <jv/flat-expr-tree.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace {
+
+using Tree = jv::FlatExprTree<double, 32, 4>; // tiny blocks to test the edges
+
+// A user-defined node, not pure by default, so it must not be folded.
+struct Impure final : jv::IExprNode<double> {
+    void move_to(void* dst) && noexcept override {
+        new (dst) Impure(std::move(*this));
+    }
+    auto arity() const noexcept -> std::uint32_t override { return 0; }
+    auto eval(double const*, double const*) const -> double override {
+        return 7;
+    }
+    void eval_batch(double const* const*, double const* const*, std::size_t,
+                    std::size_t count, double* out) const override {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = 7;
+    }
+};
+
+} // namespace
+
+TEST_CASE("FlatExprTree evaluation", "[utils][bounded-poly][FlatExprTree]") {
+    // (x + 2) * (y - x) / 4
+    Tree::Builder builder;
+    auto x1 = builder.variable(0);
+    auto x2 = builder.variable(0);
+    auto y = builder.variable(1);
+    auto sum = builder.function(std::plus<>{}, x1, builder.constant(2));
+    auto diff = builder.function(std::minus<>{}, y, x2);
+    auto product = builder.function(std::multiplies<>{}, sum, diff);
+    auto root =
+        builder.function(std::divides<>{}, product, builder.constant(4));
+    Tree tree = std::move(builder).build(root);
+    REQUIRE(tree.size() == 9);
+
+    // post-order: children come before their parent, and links point to them
+    for (std::size_t i = 0; i < tree.size(); ++i) {
+        auto [first, last] = tree.children(i);
+        CHECK(std::size_t(last - first) == tree.node(i)->arity());
+        for (; first != last; ++first)
+            CHECK(*first < i);
+    }
+
+    auto expected = [](double x, double y) { return (x + 2) * (y - x) / 4; };
+
+    double row[] = {3, 11};
+    CHECK(tree.evaluate(row) == expected(3, 11));
+
+    std::vector<double> xs, ys;
+    for (int i = 0; i < 10; ++i) {
+        xs.push_back(i);
+        ys.push_back(i * i);
+    }
+    double const* columns[] = {xs.data(), ys.data()};
+    std::vector<double> out(10);
+    tree.evaluate_batch(columns, 10, out.data());
+    for (int i = 0; i < 10; ++i)
+        CHECK(out[i] == expected(xs[i], ys[i]));
+}
+
+TEST_CASE("FlatExprTree constant folding",
+          "[utils][bounded-poly][FlatExprTree]") {
+    Tree::Builder builder;
+    // x * (1 + 2 * 3) + impure: `1 + 2 * 3` is folded, `impure` is not
+    auto seven = builder.function(
+        std::plus<>{}, builder.constant(1),
+        builder.function(std::multiplies<>{}, builder.constant(2),
+                         builder.constant(3)));
+    auto scaled = builder.function(std::multiplies<>{}, builder.variable(0),
+                                   seven);
+    auto impure = builder.add<Impure>({});
+    auto root = builder.function(std::plus<>{}, scaled, impure);
+    Tree tree = std::move(builder).build(root);
+
+    // x, 7, *, impure, +
+    REQUIRE(tree.size() == 5);
+    double value = 0;
+    CHECK(tree.node(1)->as_constant(value));
+    CHECK(value == 7);
+    double row[] = {2};
+    CHECK(tree.evaluate(row) == 2 * 7 + 7);
+
+    // lambdas are only folded when said to be pure
+    auto negate = [](double a) { return -a; };
+    Tree::Builder opaque;
+    auto o = opaque.function(negate, opaque.constant(5));
+    Tree kept = std::move(opaque).build(o);
+    CHECK(kept.size() == 2);
+    CHECK(kept.evaluate(nullptr) == -5);
+
+    Tree::Builder all_constant;
+    auto c = all_constant.pure_function(negate, all_constant.constant(5));
+    Tree folded = std::move(all_constant).build(c);
+    CHECK(folded.size() == 1);
+    CHECK(folded.evaluate(nullptr) == -5);
+}
+
+TEST_CASE("FlatExprTree of a deep tree",
+          "[utils][bounded-poly][FlatExprTree]") {
+    constexpr int Depth = 200'000; // far too deep for a recursive build
+    Tree::Builder builder;
+    auto node = builder.variable(0);
+    for (int i = 0; i < Depth; ++i)
+        node = builder.function(std::negate<>{}, node);
+    Tree tree = std::move(builder).build(node);
+    CHECK(tree.size() == std::size_t{Depth} + 1);
+    double row[] = {3};
+    CHECK(tree.evaluate(row) == 3);
+
+    Tree::Builder constants;
+    auto folded = constants.constant(3);
+    for (int i = 0; i < Depth + 1; ++i)
+        folded = constants.function(std::negate<>{}, folded);
+    Tree constant = std::move(constants).build(folded);
+    CHECK(constant.size() == 1);
+    CHECK(constant.evaluate(nullptr) == -3);
+}
+
+TEST_CASE("FlatExprTree rejects shared nodes",
+          "[utils][bounded-poly][FlatExprTree]") {
+    Tree::Builder builder;
+    auto x = builder.variable(0);
+    builder.function(std::negate<>{}, x);
+    CHECK_THROWS_AS(builder.function(std::negate<>{}, x),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(builder.add<Impure>({builder.variable(1)}),
+                    std::invalid_argument); // wrong arity
+}
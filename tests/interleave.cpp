@@ -0,0 +1,116 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/interleave.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct IOp {
+    virtual ~IOp() noexcept {}
+    virtual void apply(long& lhs) const noexcept = 0;
+};
+
+struct Add final : IOp {
+    long rhs;
+    Add(long r) noexcept : rhs(r) {}
+    void apply(long& lhs) const noexcept override { lhs += rhs; }
+};
+
+struct Mul final : IOp {
+    long rhs;
+    Mul(long r) noexcept : rhs(r) {}
+    void apply(long& lhs) const noexcept override { lhs = lhs * rhs % 1009; }
+};
+
+using Op = jv::BoundedPoly<std::aligned_storage_t<16, 8>, IOp>;
+
+auto make_pipelines(std::size_t nb, std::size_t length)
+    -> std::vector<std::vector<Op>> {
+    std::vector<std::vector<Op>> pipelines(nb);
+    for (std::size_t p = 0; p < nb; ++p) {
+        // different lengths, some empty
+        std::size_t const n = length * (p % 4) / 3 + p % 7;
+        for (std::size_t i = 0; i < n; ++i) {
+            if ((i + p) % 3 == 0)
+                pipelines[p].emplace_back(Mul{long(i % 5 + 2)});
+            else
+                pipelines[p].emplace_back(Add{long(i + p)});
+        }
+    }
+    return pipelines;
+}
+
+auto serial(std::vector<std::vector<Op>> const& pipelines)
+    -> std::vector<long> {
+    std::vector<long> results(pipelines.size(), 1);
+    for (std::size_t p = 0; p < pipelines.size(); ++p)
+        for (auto const& op : pipelines[p])
+            op->apply(results[p]);
+    return results;
+}
+
+auto apply = [](Op const& op, long& state) { op->apply(state); };
+
+} // namespace
+
+TEST_CASE("evaluate_interleaved", "[utils][evaluate_interleaved]") {
+    auto const pipelines = make_pipelines(37, 50);
+    auto const expected = serial(pipelines);
+
+    for (std::size_t k : {1, 2, 3, 4, 8, 100}) {
+        std::vector<long> results(pipelines.size(), 1);
+        std::size_t const used =
+            jv::evaluate_interleaved(pipelines, results, apply, k);
+        CHECK(used == (k == 3 ? 2 : k == 100 ? 8 : k));
+        CHECK(results == expected);
+    }
+
+    std::vector<std::vector<Op>> const none;
+    std::vector<long> no_results;
+    jv::evaluate_interleaved(none, no_results, apply);
+}
+
+TEST_CASE("evaluate_interleaved tunes k", "[utils][evaluate_interleaved]") {
+    // enough elements for the tuning to take place
+    auto const pipelines = make_pipelines(256, 600);
+    auto const expected = serial(pipelines);
+
+    std::vector<long> results(pipelines.size(), 1);
+    std::size_t const k = jv::evaluate_interleaved(pipelines, results, apply);
+    CHECK((k == 1 || k == 2 || k == 4 || k == 8));
+    CHECK(results == expected);
+
+    // tuned once per tuner
+    jv::InterleaveTuner tuner;
+    CHECK(tuner.factor() == 0);
+    results.assign(pipelines.size(), 1);
+    std::size_t const tuned =
+        jv::evaluate_interleaved(pipelines, results, apply, tuner);
+    CHECK(tuner.factor() == tuned);
+    CHECK(tuner.nb_pipelines() == 256);
+    CHECK(results == expected);
+
+    tuner.record(2, 256); // as if 2 was the fastest
+    std::vector<long> again(pipelines.size(), 1);
+    CHECK(jv::evaluate_interleaved(pipelines, again, apply, tuner) == 2);
+    CHECK(again == expected);
+
+    // tuned again for many more pipelines
+    auto const more = make_pipelines(1024, 10);
+    std::vector<long> more_results(more.size(), 1);
+    jv::evaluate_interleaved(more, more_results, apply, tuner);
+    CHECK(tuner.nb_pipelines() == 1024);
+    CHECK(more_results == serial(more));
+
+    // too few pipelines to tune: the tuner is left as is
+    auto const few = make_pipelines(10, 10);
+    std::vector<long> few_results(few.size(), 1);
+    jv::InterleaveTuner untuned;
+    jv::evaluate_interleaved(few, few_results, apply, untuned);
+    CHECK(untuned.factor() == 0);
+    CHECK(few_results == serial(few));
+}
@@ -0,0 +1,139 @@
+#include "catch.hpp"
+
+#include <jv/logger.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+auto lines_of(std::string const& text) -> std::vector<std::string> {
+    std::vector<std::string> lines;
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);)
+        lines.push_back(line);
+    return lines;
+}
+
+} // namespace
+
+TEST_CASE("Logger formats records on its writer thread",
+          "[utils][bounded-poly][Logger]") {
+    std::ostringstream out;
+    {
+        jv::Logger<> logger{out};
+        JV_LOG(logger, "no argument");
+        JV_LOG(logger, "x = {}, y = {}", 1, 2.5);
+        JV_LOG(logger, "{} is {} years old", "Alice", 30);
+        JV_LOG(logger, "missing {} and {}", 'a');
+        JV_LOG(logger, "extra {}", 1, 2);
+        logger.flush();
+        CHECK(logger.dropped() == 0);
+    }
+    auto lines = lines_of(out.str());
+    REQUIRE(lines.size() == 5);
+    CHECK(lines[0] == "no argument");
+    CHECK(lines[1] == "x = 1, y = 2.5");
+    CHECK(lines[2] == "Alice is 30 years old");
+    CHECK(lines[3] == "missing a and ");
+    CHECK(lines[4] == "extra 1");
+}
+
+TEST_CASE("Logger keeps the order of each thread",
+          "[utils][bounded-poly][Logger]") {
+    constexpr int NbThreads = 4;
+    constexpr int PerThread = 5000;
+
+    std::ostringstream out;
+    {
+        jv::Logger<32, 256> logger{out, jv::OverflowPolicy::Block};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < NbThreads; ++t)
+            threads.emplace_back([&logger, t] {
+                for (int i = 0; i < PerThread; ++i)
+                    JV_LOG(logger, "{} {}", t, i);
+            });
+        for (auto& thread : threads)
+            thread.join();
+        // the destructor writes what remains
+    }
+
+    auto lines = lines_of(out.str());
+    REQUIRE(lines.size() == std::size_t(NbThreads * PerThread));
+    std::vector<int> next(NbThreads, 0);
+    int out_of_order = 0;
+    for (auto const& line : lines) {
+        int t = 0, i = 0;
+        std::istringstream{line} >> t >> i;
+        out_of_order += next[t] != i;
+        next[t] = i + 1;
+    }
+    CHECK(out_of_order == 0);
+}
+
+TEST_CASE("Logger drops records when its ring is full",
+          "[utils][bounded-poly][Logger]") {
+    std::ostringstream out;
+    // the writer wakes up rarely, so the ring fills up
+    jv::Logger<32, 4> logger{out, jv::OverflowPolicy::Drop,
+                             std::chrono::seconds{10}};
+    for (int i = 0; i < 100; ++i)
+        JV_LOG(logger, "{}", i);
+    logger.flush();
+
+    auto written = lines_of(out.str()).size();
+    CHECK(logger.dropped() > 0);
+    CHECK(written + logger.dropped() == 100);
+}
+
+TEST_CASE("Logger copies C strings", "[utils][bounded-poly][Logger]") {
+    std::ostringstream out;
+    {
+        // the writer only wakes up on flush, after the buffer is reused
+        jv::Logger<> logger{out, jv::OverflowPolicy::Drop,
+                            std::chrono::seconds{10}};
+        char buffer[8] = "first";
+        std::string text = "a long enough string";
+        JV_LOG(logger, "{} {}", buffer, jv::LogString<7>{text.c_str()});
+        std::strcpy(buffer, "second");
+        text.assign(text.size(), '?');
+        logger.flush();
+    }
+    CHECK(out.str() == "first a long\n");
+}
+
+TEST_CASE("Logger frees the rings of exited threads",
+          "[utils][bounded-poly][Logger]") {
+    std::ostringstream out;
+    jv::Logger<> logger{out};
+    JV_LOG(logger, "main");
+    for (int t = 0; t < 8; ++t)
+        std::thread{[&logger, t] { JV_LOG(logger, "thread {}", t); }}.join();
+    logger.flush();
+    CHECK(logger.nb_rings() == 1); // the main thread is still running
+    CHECK(lines_of(out.str()).size() == 9);
+
+    // a thread logging to a logger destroyed before it exits
+    std::atomic<bool> logged{false}, done{false}; // outlive `late`
+    std::thread late;
+    {
+        std::ostringstream late_out;
+        jv::Logger<> short_lived{late_out};
+        late = std::thread{[&] {
+            JV_LOG(short_lived, "late");
+            logged = true;
+            while (!done)
+                std::this_thread::yield();
+        }};
+        while (!logged)
+            std::this_thread::yield();
+    }
+    done = true; // exits after the logger is destroyed
+    late.join();
+}
@@ -123,6 +123,7 @@ TEST_CASE("UniversalMover", "[utils][bounded-poly][UniversalMover]") {
     reinterpret_cast<Base&>(dst).~Base();
 
     mover = Mover{static_cast<Derived const*>(nullptr)};
+    CHECK(mover.size() == sizeof(Derived));
 
     REQUIRE(*derived.i == 50);
     REQUIRE(*derived.f == 0);
@@ -279,4 +280,49 @@ TEST_CASE("BoundedPoly + Stateless Mover",
     a.swap(b);
     REQUIRE(typeid(a_ref) == typeid(Derived2));
     REQUIRE(typeid(b_ref) == typeid(Base2));
-}
\ No newline at end of file
+}
+
+TEST_CASE("BoundedPoly with a Header", "[utils][bounded-poly][BoundedPoly]") {
+    struct Key {
+        int priority;
+    };
+
+    using PolyKey =
+        jv::BoundedPoly<Storage, Base, jv::UniversalMover<Base>, Key>;
+    using PolyKeyVM =
+        jv::BoundedPolyVM<Storage2, Base2, &Base2::move_to, Key>;
+    REQUIRE(sizeof(PolyKeyVM) > sizeof(Storage2));
+    REQUIRE(sizeof(jv::BoundedPolyVM<Storage2, Base2, &Base2::move_to>) ==
+            sizeof(Storage2));
+
+    PolyKey a{Key{1}, Derived{50, 0}};
+    PolyKey b{Key{2}, std::in_place_type_t<Base>{}, 42};
+    PolyKey c{Base{}}; // value-initialized header
+    CHECK(a.header().priority == 1);
+    CHECK(b.header().priority == 2);
+    CHECK(c.header().priority == 0);
+
+    a.swap(b);
+    CHECK(a.header().priority == 2);
+    CHECK(*a->i == 42);
+    CHECK(b.header().priority == 1);
+    CHECK(*b->i == 50);
+
+    c = std::move(a);
+    CHECK(c.header().priority == 2);
+    PolyKey d{std::move(c)};
+    CHECK(d.header().priority == 2);
+    CHECK(*d->i == 42);
+
+    d.emplace<Derived>(); // keeps the header
+    CHECK(d.header().priority == 2);
+    d.emplace_with_header<Base>(Key{3});
+    CHECK(d.header().priority == 3);
+    CHECK(typeid(d.get()) == typeid(Base));
+    d.header().priority = 4;
+    CHECK(static_cast<PolyKey const&>(d).header().priority == 4);
+
+    PolyKeyVM e{Key{5}, Derived2{1, 2.f}};
+    CHECK(e.header().priority == 5);
+    CHECK(typeid(e.get()) == typeid(Derived2));
+}
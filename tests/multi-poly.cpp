@@ -0,0 +1,115 @@
+#include "catch.hpp"
+
+#include <jv/multi-poly.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const -> double = 0;
+};
+
+struct ISerializable {
+    virtual ~ISerializable() noexcept {}
+    virtual auto serialize() const -> std::string = 0;
+};
+
+struct IScalable {
+    virtual ~IScalable() noexcept {}
+    virtual void scale(double factor) = 0;
+};
+
+struct Square final : IShape, ISerializable, IScalable {
+    double side;
+    Square(double s) noexcept : side(s) {}
+    auto area() const -> double override { return side * side; }
+    auto serialize() const -> std::string override {
+        return "square " + std::to_string(int(side));
+    }
+    void scale(double factor) override { side *= factor; }
+};
+
+struct Dot final : IShape { // implements no other interface
+    auto area() const -> double override { return 0; }
+};
+
+// as in every BoundedPoly, Base comes first
+struct Text final : IShape, ISerializable {
+    std::string text;
+    Text(std::string t) : text(std::move(t)) {}
+    auto area() const -> double override { return double(text.size()); }
+    auto serialize() const -> std::string override { return text; }
+};
+
+// a type which is stored, and one derived from it used as an interface
+struct Disk : IShape {
+    auto area() const -> double override { return 3; }
+};
+
+struct IDiskView : Disk {};
+
+struct IVirtual {
+    virtual ~IVirtual() noexcept {}
+};
+
+struct WithVirtualBase final : IShape, virtual IVirtual {
+    auto area() const -> double override { return 1; }
+};
+
+using Shape = jv::MultiPoly<std::aligned_union_t<0, Square, Dot, Text>, IShape,
+                            ISerializable, IScalable>;
+
+} // namespace
+
+TEST_CASE("MultiPoly interfaces", "[utils][bounded-poly][MultiPoly]") {
+    // the offsets are measured on constructed values
+    STATIC_REQUIRE(jv::details::registers_types<
+                   jv::InterfaceMover<IShape, ISerializable, IScalable>,
+                   IShape>::value);
+
+    std::vector<Shape> shapes;
+    shapes.emplace_back(Square{2});
+    shapes.emplace_back(Dot{});
+    shapes.emplace_back(Text{"hello"});
+
+    CHECK(shapes[0].as<ISerializable>()->serialize() == "square 2");
+    CHECK(shapes[0].as<ISerializable>() ==
+          dynamic_cast<ISerializable*>(&shapes[0].get()));
+    CHECK(shapes[1].as<ISerializable>() == nullptr);
+    CHECK(shapes[1].as<IScalable>() == nullptr);
+    CHECK(shapes[2].as<ISerializable>()->serialize() == "hello");
+    CHECK(shapes[2].as<IScalable>() == nullptr);
+    CHECK(shapes[2].as<IShape>()->area() == 5);
+
+    shapes[0].as<IScalable>()->scale(3);
+    CHECK(shapes[0]->area() == 36);
+
+    // the offsets follow the value when it is moved or replaced
+    shapes[1].swap(shapes[0]);
+    CHECK(shapes[0].as<ISerializable>() == nullptr);
+    CHECK(shapes[1].as<ISerializable>()->serialize() == "square 6");
+    shapes[0] = Text{"bye"};
+    Shape const moved{std::move(shapes[0])};
+    CHECK(moved.as<ISerializable>()->serialize() == "bye");
+    CHECK(moved.stored_size() == sizeof(Text));
+}
+
+TEST_CASE("MultiPoly only uses bases as interfaces",
+          "[utils][bounded-poly][MultiPoly]") {
+    using jv::details::is_static_base;
+    STATIC_REQUIRE(is_static_base<ISerializable, Square>::value);
+    STATIC_REQUIRE_FALSE(is_static_base<IDiskView, Disk>::value);
+    STATIC_REQUIRE_FALSE(is_static_base<IVirtual, WithVirtualBase>::value);
+    STATIC_REQUIRE_FALSE(is_static_base<ISerializable, Dot>::value);
+
+    // Disk is an IDiskView's base, not the other way around
+    using DiskPoly =
+        jv::MultiPoly<std::aligned_union_t<0, Disk>, IShape, IDiskView>;
+    DiskPoly disk{Disk{}};
+    CHECK(disk.as<IDiskView>() == nullptr);
+    CHECK(disk->area() == 3);
+}
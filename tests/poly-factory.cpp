@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-factory.hpp>
+#include <jv/poly-vector.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const -> double = 0;
+};
+
+struct Square final : IShape {
+    double side;
+    Square(double s) noexcept : side(s) {}
+    auto area() const -> double override { return side * side; }
+};
+
+struct Rectangle final : IShape {
+    double width, height;
+    Rectangle(double w, double h) noexcept : width(w), height(h) {}
+    auto area() const -> double override { return width * height; }
+};
+
+template <int K> struct Scaled final : IShape {
+    double x;
+    Scaled(double a, double b) noexcept : x(a * b) {}
+    auto area() const -> double override { return K * x; }
+};
+
+using Shape =
+    jv::BoundedPoly<std::aligned_union_t<0, Square, Rectangle>, IShape>;
+using Factory = jv::PolyFactory<Shape, double, double>;
+
+template <int... K>
+void add_scaled(Factory& factory, std::integer_sequence<int, K...>) {
+    (factory.add<Scaled<K>>("scaled" + std::to_string(K)), ...);
+}
+
+} // namespace
+
+TEST_CASE("PolyFactory", "[utils][PolyFactory]") {
+    Factory factory;
+    factory.add<Rectangle>("rectangle");
+    factory.add("square", [](void* dst, double side, double) {
+        new (dst) Shape{Square{side}};
+    });
+    add_scaled(factory, std::make_integer_sequence<int, 200>{});
+    CHECK_THROWS_AS(factory.add<Rectangle>("square"), std::invalid_argument);
+    CHECK_FALSE(factory.contains("square")); // not frozen yet
+
+    factory.freeze();
+    CHECK(factory.size() == 202);
+    CHECK_THROWS_AS(factory.add<Rectangle>("other"), std::logic_error);
+    CHECK(factory.contains("square"));
+    CHECK(factory.contains("scaled199"));
+    CHECK_FALSE(factory.contains("scaled200"));
+    CHECK_FALSE(factory.contains(""));
+
+    CHECK(factory.create("rectangle", 2, 3)->area() == 6);
+    CHECK(factory.create("scaled7", 2, 3)->area() == 42);
+    CHECK_THROWS_AS(factory.create("circle", 1, 1), std::invalid_argument);
+
+    std::vector<std::tuple<std::string, double, double>> records{
+        {"square", 2, 0}, {"scaled3", 1, 1}, {"rectangle", 1, 5}};
+    jv::PolyVector<Shape> in_place;
+    factory.create_into(in_place, records);
+    std::vector<Shape> moved;
+    factory.create_into(moved, records);
+    REQUIRE(in_place.size() == 3);
+    REQUIRE(moved.size() == 3);
+    for (std::size_t i = 0; i < 3; ++i)
+        CHECK(in_place[i]->area() == moved[i]->area());
+    CHECK(in_place[1]->area() == 3);
+
+    records.emplace_back("unknown", 0, 0);
+    CHECK_THROWS_AS(factory.create_into(in_place, records),
+                    std::invalid_argument);
+    CHECK(in_place.size() == 6); // the records before are kept
+}
+
+TEST_CASE("PolyFactory without types", "[utils][PolyFactory]") {
+    Factory factory;
+    factory.freeze();
+    CHECK(factory.frozen());
+    CHECK_FALSE(factory.contains("square"));
+}
@@ -0,0 +1,204 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-vector.hpp>
+#include <jv/uninitialized.hpp>
+
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+int nb_alive = 0;
+
+struct IName {
+    IName() noexcept { ++nb_alive; }
+    IName(IName&&) noexcept { ++nb_alive; }
+    virtual ~IName() noexcept { --nb_alive; }
+    virtual auto name() const -> std::string = 0;
+};
+
+struct Short final : IName {
+    char c;
+    Short(char x) noexcept : c(x) {}
+    auto name() const -> std::string override { return std::string(1, c); }
+};
+
+// Points to itself: relocating it with memcpy would be wrong.
+struct SelfReferencing final : IName {
+    char c;
+    char* self;
+    SelfReferencing(char x) noexcept : c(x), self(&c) {}
+    SelfReferencing(SelfReferencing&& other) noexcept
+        : IName(std::move(other)), c(other.c), self(&c) {}
+    auto name() const -> std::string override { return std::string(1, *self); }
+};
+
+using Name =
+    jv::BoundedPoly<std::aligned_union_t<0, Short, SelfReferencing>, IName>;
+
+auto names(jv::PolyVector<Name> const& vec) -> std::string {
+    std::string result;
+    for (Name const& name : vec)
+        result += name->name();
+    return result;
+}
+
+struct Pod {
+    int a, b;
+};
+
+struct IValue {
+    virtual ~IValue() noexcept = default;
+    virtual auto value() const -> int = 0;
+};
+
+struct Small final : IValue {
+    int v;
+    Small(int x) noexcept : v(x) {}
+    auto value() const -> int override { return v; }
+};
+
+struct Large final : IValue {
+    int v[50];
+    Large(int x) noexcept : v{} { v[49] = x; }
+    auto value() const -> int override { return v[49]; }
+};
+
+using Value = jv::BoundedPoly<std::aligned_storage_t<256, 16>, IValue>;
+
+} // namespace
+
+// Small and Large have no pointer to themselves.
+template <> struct jv::is_trivially_relocatable<Value> {
+    static constexpr bool value = true;
+};
+
+TEST_CASE("Uninitialized algorithms", "[utils][uninitialized]") {
+    static_assert(jv::is_trivially_relocatable_v<Pod>);
+    static_assert(!jv::is_trivially_relocatable_v<Name>);
+
+    std::aligned_storage_t<sizeof(Pod) * 6, alignof(Pod)> raw;
+    Pod* pods = reinterpret_cast<Pod*>(&raw);
+    for (int i = 0; i < 4; ++i)
+        new (pods + i) Pod{i, -i};
+    jv::uninitialized_relocate_n(pods, 4, pods + 2); // overlapping
+    CHECK(pods[2].a == 0);
+    CHECK(pods[5].a == 3);
+
+    std::aligned_storage_t<sizeof(std::string) * 3, alignof(std::string)> buf;
+    auto* strings = reinterpret_cast<std::string*>(&buf);
+    std::vector<std::string> source{"a", "b", "c"};
+    auto* end = jv::uninitialized_move_if_noexcept(
+        source.data(), source.data() + 3, strings);
+    CHECK(end == strings + 3);
+    CHECK(strings[2] == "c");
+    jv::destroy(strings, end);
+}
+
+TEST_CASE("Relocation copies the live prefix only",
+          "[utils][uninitialized][bounded-poly]") {
+    Value small{Small{1}};
+    Value large{Large{2}};
+    CHECK(small.stored_size() == sizeof(Small));
+    CHECK(large.stored_size() == sizeof(Large));
+    CHECK(small.live_size() < sizeof(Value) / 4);
+    CHECK(large.live_size() <= sizeof(Value));
+
+    // the bytes past the live prefix of the destination are not written
+    std::aligned_storage_t<sizeof(Value), alignof(Value)> raw;
+    auto* bytes = reinterpret_cast<unsigned char*>(&raw);
+    std::fill(bytes, bytes + sizeof(Value), 0xAB);
+    std::size_t const live = small.live_size();
+    auto* dst = reinterpret_cast<Value*>(&raw);
+    jv::relocate_at(&small, dst);
+    CHECK((*dst)->value() == 1);
+    CHECK(std::all_of(bytes + live, bytes + sizeof(Value),
+                      [](unsigned char b) { return b == 0xAB; }));
+    new (&small) Value{std::move(*dst)};
+    dst->~Value();
+
+    jv::PolyVector<Value> vec;
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3 == 0)
+            vec.push_back(Large{i});
+        else
+            vec.push_back(Small{i});
+    }
+    vec.insert(0, Small{-1});
+    vec.erase(50);
+    int sum = 0;
+    for (Value const& v : vec)
+        sum += v->value();
+    CHECK(sum == 99 * 100 / 2 - 1 - 49);
+}
+
+TEST_CASE("PolyVector insertion and erasure",
+          "[utils][bounded-poly][PolyVector]") {
+    nb_alive = 0;
+    {
+        jv::PolyVector<Name> vec;
+        for (char c : std::string{"bdf"})
+            vec.push_back(Short{c});
+        vec.emplace_back<SelfReferencing>('g');
+        vec.insert(0, SelfReferencing{'a'});
+        vec.insert(2, Short{'c'});
+        vec.insert(4, SelfReferencing{'e'});
+        CHECK(names(vec) == "abcdefg");
+        CHECK(nb_alive == 7);
+
+        vec[0].swap(vec[1]); // relocates, so no moved-from value is left
+        CHECK(names(vec) == "bacdefg");
+        CHECK(nb_alive == 7);
+        vec[1].swap(vec[0]);
+
+        for (int i = 0; i < 100; ++i) // several reallocations
+            vec.insert(vec.size() / 2, Short{'x'});
+        for (int i = 0; i < 100; ++i)
+            vec.erase(3);
+        CHECK(names(vec) == "abcdefg");
+        CHECK(nb_alive == 7);
+
+        vec.erase(0);
+        vec.pop_back();
+        CHECK(names(vec) == "bcdef");
+
+        jv::PolyVector<Name> moved{std::move(vec)};
+        CHECK(vec.empty());
+        CHECK(names(moved) == "bcdef");
+    }
+    CHECK(nb_alive == 0);
+}
+
+TEST_CASE("Relocation and destruction by runs",
+          "[utils][uninitialized][bounded-poly][PolyVector]") {
+    static_assert(jv::details::has_runs<Name>::value);
+    static_assert(!jv::details::has_runs<Pod>::value);
+
+    nb_alive = 0;
+    {
+        jv::PolyVector<Name> vec;
+        std::string expected;
+        for (int i = 0; i < 50; ++i) { // runs of 1 to 4 elements
+            char const c = static_cast<char>('a' + i % 26);
+            if (i % 7 < 3)
+                vec.emplace_back<SelfReferencing>(c);
+            else
+                vec.emplace_back<Short>(c);
+            expected += c;
+        }
+        CHECK(Name::run_length(vec.begin(), vec.end()) == 3);
+        CHECK(Name::run_length(vec.begin() + 3, vec.end()) == 4);
+        CHECK(Name::run_length(vec.end() - 1, vec.end()) == 1);
+
+        vec.reserve(1000); // relocated run by run, to a new buffer
+        CHECK(names(vec) == expected);
+        CHECK(nb_alive == 50);
+
+        vec.clear(); // destroyed run by run
+        CHECK(nb_alive == 0);
+    }
+    CHECK(nb_alive == 0);
+}
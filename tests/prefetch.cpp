@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/concurrent-poly-vector.hpp>
+#include <jv/prefetch.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct IValue {
+    virtual ~IValue() noexcept {}
+    virtual auto value() const noexcept -> int = 0;
+};
+
+struct Plain : IValue {
+    int v;
+    Plain(int x) noexcept : v(x) {}
+    auto value() const noexcept -> int override { return v; }
+};
+
+struct Negated : IValue {
+    int v;
+    char padding[100] = {};
+    Negated(int x) noexcept : v(x) {}
+    auto value() const noexcept -> int override { return -v; }
+};
+
+using Value = jv::BoundedPoly<std::aligned_storage_t<128>, IValue>;
+
+} // namespace
+
+TEST_CASE("for_each_prefetch visits every element in order",
+          "[utils][bounded-poly][prefetch]") {
+    std::vector<Value> values;
+    for (int i = 0; i < 100; ++i) {
+        if (i % 3)
+            values.emplace_back(Plain{i});
+        else
+            values.emplace_back(Negated{-i});
+    }
+    for (std::size_t distance : {0, 1, 2, 8, 500}) {
+        int expected = 0;
+        jv::for_each_prefetch(
+            values, [&](Value& v) { CHECK(v->value() == expected++); },
+            distance);
+        CHECK(expected == 100);
+    }
+
+    int ints[] = {1, 2, 3};
+    int sum = 0;
+    jv::for_each_prefetch(ints, [&](int x) { sum += x; });
+    CHECK(sum == 6);
+
+    jv::ConcurrentPolyVector<Value, 4> vec;
+    for (int i = 0; i < 50; ++i)
+        vec.emplace_back(Plain{i});
+    int expected = 0;
+    vec.for_each([&](Value const& v) { CHECK(v->value() == expected++); }, 8);
+    CHECK(expected == 50);
+}
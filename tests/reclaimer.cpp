@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-vector.hpp>
+#include <jv/reclaimer.hpp>
+#include <jv/thread-pool.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+std::atomic<int> nb_alive{0};
+std::atomic<int> nb_destroyed_elsewhere{0};
+std::thread::id owner;
+
+// destructions of each value, while `counting`
+std::atomic<bool> counting{false};
+std::atomic<int> destructions[10'000];
+
+struct IResource {
+    IResource() noexcept { ++nb_alive; }
+    IResource(IResource&&) noexcept { ++nb_alive; }
+    virtual ~IResource() noexcept {
+        --nb_alive;
+        if (std::this_thread::get_id() != owner)
+            ++nb_destroyed_elsewhere;
+    }
+    virtual auto value() const noexcept -> int = 0;
+};
+
+struct Owning final : IResource {
+    std::unique_ptr<int> p;
+    Owning(int v) : p(std::make_unique<int>(v)) {}
+    Owning(Owning&&) noexcept = default;
+    ~Owning() noexcept override {
+        if (counting && p)
+            ++destructions[*p];
+    }
+    auto value() const noexcept -> int override { return *p; }
+};
+
+using Resource =
+    jv::BoundedPoly<std::aligned_storage_t<2 * sizeof(void*)>, IResource>;
+
+} // namespace
+
+TEST_CASE("PolyVector::clear on a ThreadPool", "[utils][Reclaimer]") {
+    owner = std::this_thread::get_id();
+    for (std::size_t nb_workers : {0, 3}) {
+        jv::ThreadPool pool{nb_workers};
+        jv::PolyVector<Resource> v;
+        for (int i = 0; i < 10'000; ++i)
+            v.emplace_back<Owning>(i);
+        REQUIRE(nb_alive == 10'000);
+
+        for (auto& count : destructions)
+            count = 0;
+        counting = true;
+        v.clear(pool, 100);
+        counting = false;
+        CHECK(v.empty());
+        CHECK(nb_alive == 0);
+
+        // each element exactly once, whichever threads destroyed them
+        int nb_once = 0;
+        for (auto const& count : destructions)
+            nb_once += count == 1;
+        CHECK(nb_once == 10'000);
+
+        v.emplace_back<Owning>(42);
+        CHECK(v[0]->value() == 42);
+    }
+    CHECK(nb_alive == 0);
+}
+
+TEST_CASE("Reclaimer destroys on its own thread", "[utils][Reclaimer]") {
+    owner = std::this_thread::get_id();
+    nb_destroyed_elsewhere = 0;
+    {
+        jv::Reclaimer reclaimer;
+        jv::PolyVector<Resource> v;
+        for (int i = 0; i < 1000; ++i)
+            v.emplace_back<Owning>(i);
+
+        reclaimer.defer(std::move(v));
+        CHECK(v.empty());
+        reclaimer.flush();
+        CHECK(nb_alive == 0);
+        CHECK(nb_destroyed_elsewhere == 1000);
+
+        // not movable containers go through a unique_ptr
+        auto p = std::make_unique<Resource>(Owning{1});
+        reclaimer.defer(std::move(p));
+        CHECK(p == nullptr);
+
+        // left for the destructor of the reclaimer
+        std::vector<Resource> w;
+        w.emplace_back(Owning{2});
+        reclaimer.defer(std::move(w));
+    }
+    CHECK(nb_alive == 0);
+    CHECK(nb_destroyed_elsewhere == 1002);
+}
@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-vector.hpp>
+#include <jv/recycler.hpp>
+
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct Counts {
+    int constructed = 0, moved = 0, destroyed = 0, reset = 0;
+};
+
+Counts counts;
+
+struct IJob {
+    virtual ~IJob() noexcept {}
+    virtual auto id() const noexcept -> int = 0;
+};
+
+struct Batch final : IJob {
+    int id_;
+    std::vector<int> buffer;
+    Batch(int i) : id_(i) {
+        ++counts.constructed;
+        buffer.reserve(1000);
+    }
+    Batch(Batch&& other) noexcept
+        : id_(other.id_), buffer(std::move(other.buffer)) {
+        ++counts.moved;
+    }
+    ~Batch() noexcept { ++counts.destroyed; }
+    void reset(int i) {
+        if (i < 0)
+            throw std::invalid_argument{"negative id"};
+        ++counts.reset;
+        id_ = i;
+        buffer.clear();
+    }
+    auto id() const noexcept -> int override { return id_; }
+};
+
+struct Ping final : IJob {
+    auto id() const noexcept -> int override { return -1; }
+};
+
+using Job = jv::BoundedPoly<std::aligned_storage_t<48, 8>, IJob>;
+using JobRecycler = jv::Recycler<IJob, Batch>;
+
+auto batch_of(Job& job) -> Batch& { return static_cast<Batch&>(*job); }
+
+} // namespace
+
+TEST_CASE("BoundedPoly::emplace_recycled", "[utils][Recycler]") {
+    counts = {};
+    JobRecycler recycler{2};
+    Job job{Ping{}};
+
+    // nothing to recycle: constructed aside, as the constructor may throw
+    job.emplace_recycled<Batch>(recycler, 1);
+    CHECK(job->id() == 1);
+    CHECK(counts.constructed == 1);
+    CHECK(counts.moved == 1);
+    CHECK(counts.destroyed == 1);
+    int const* buffer = batch_of(job).buffer.data();
+
+    // the stored Batch is reset in place
+    counts = {};
+    job.emplace_recycled<Batch>(recycler, 2);
+    CHECK(job->id() == 2);
+    CHECK(counts.reset == 1);
+    CHECK(counts.constructed + counts.moved + counts.destroyed == 0);
+    CHECK(batch_of(job).buffer.data() == buffer);
+
+    // relocated into the free list: one move and one destruction
+    counts = {};
+    job.emplace_recycled<Ping>(recycler);
+    CHECK(job->id() == -1);
+    CHECK(recycler.nb_free<Batch>() == 1);
+    CHECK(counts.moved == 1);
+    CHECK(counts.destroyed == 1);
+
+    // relocated back: one move and one destruction, no construction
+    counts = {};
+    job.emplace_recycled<Batch>(recycler, 3);
+    CHECK(job->id() == 3);
+    CHECK(recycler.nb_free<Batch>() == 0);
+    CHECK(counts.reset == 1);
+    CHECK(counts.constructed == 0);
+    CHECK(counts.moved == 1);
+    CHECK(counts.destroyed == 1);
+    CHECK(batch_of(job).buffer.data() == buffer);
+    CHECK(batch_of(job).buffer.capacity() >= 1000);
+
+    // the free object is kept, and job unchanged, if reset throws
+    job.emplace_recycled<Ping>(recycler);
+    counts = {};
+    CHECK_THROWS_AS(job.emplace_recycled<Batch>(recycler, -1),
+                    std::invalid_argument);
+    CHECK(job->id() == -1);
+    CHECK(recycler.nb_free<Batch>() == 1);
+    CHECK(counts.moved + counts.destroyed == 0);
+}
+
+TEST_CASE("Recycler::recycle before destruction", "[utils][Recycler]") {
+    counts = {};
+    {
+        JobRecycler recycler{3};
+        {
+            jv::PolyVector<Job> jobs;
+            jobs.reserve(6);
+            for (int i = 0; i < 5; ++i)
+                jobs.emplace_back<Batch>(i);
+            jobs.emplace_back<Ping>();
+            CHECK_FALSE(recycler.recycle(jobs[5].get()));
+            recycler.recycle(jobs.begin(), jobs.end());
+            CHECK(recycler.nb_free<Batch>() == 3); // full
+        }
+        Job job{Ping{}};
+        for (int i = 0; i < 3; ++i) {
+            job.emplace_recycled<Batch>(recycler, 10 + i);
+            job.emplace_recycled<Ping>(recycler);
+        }
+        CHECK(counts.constructed == 5);
+        CHECK(counts.reset == 3);
+    }
+    // every Batch constructed or moved is destroyed, the free ones too
+    CHECK(counts.constructed + counts.moved == counts.destroyed);
+}
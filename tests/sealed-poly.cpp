@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <jv/sealed-poly.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+int nb_alive = 0;
+
+struct IShape {
+    IShape() noexcept { ++nb_alive; }
+    IShape(IShape const&) noexcept { ++nb_alive; }
+    virtual ~IShape() noexcept { --nb_alive; }
+    virtual auto area() const noexcept -> double = 0;
+};
+
+struct Square final : IShape {
+    double side;
+    Square(double s) noexcept : side(s) {}
+    auto area() const noexcept -> double override { return side * side; }
+};
+
+struct Named final : IShape {
+    std::unique_ptr<std::string> name; // move-only
+    Named(std::string n) : name(std::make_unique<std::string>(std::move(n))) {}
+    auto area() const noexcept -> double override { return 0; }
+};
+
+using Shape = jv::SealedPoly<IShape, Square, Named>;
+
+} // namespace
+
+TEST_CASE("SealedPoly dispatch", "[utils][SealedPoly]") {
+    nb_alive = 0;
+    {
+        std::vector<Shape> shapes;
+        shapes.emplace_back(Square{2});
+        shapes.emplace_back(Named{"circle"});
+        shapes.emplace_back(std::in_place_type_t<Square>{}, 3);
+        CHECK(nb_alive == 3);
+
+        CHECK(shapes[0].index() == 0);
+        CHECK(shapes[1].holds<Named>());
+        CHECK(shapes[1].get_if<Square>() == nullptr);
+        CHECK(*shapes[1].get_if<Named>()->name == "circle");
+
+        // virtual calls through Base
+        CHECK(shapes[0]->area() == 4);
+        CHECK((*shapes[2]).area() == 9);
+
+        // direct calls through the concrete types
+        double total = 0;
+        jv::for_each(shapes, [&](auto const& shape) { total += shape.area(); });
+        CHECK(total == 13);
+        auto const kind = jv::visit(
+            [](auto const& shape) -> std::string {
+                using T = std::decay_t<decltype(shape)>;
+                return std::is_same_v<T, Square> ? "square" : "named";
+            },
+            shapes[1]);
+        CHECK(kind == "named");
+
+        shapes[0].swap(shapes[1]);
+        CHECK(shapes[0].holds<Named>());
+        CHECK(shapes[1]->area() == 4);
+
+        shapes[0].emplace<Square>(5.0);
+        CHECK(shapes[0]->area() == 25);
+        shapes[2] = std::move(shapes[0]);
+        CHECK(shapes[2]->area() == 25);
+        CHECK(nb_alive == 3);
+    }
+    CHECK(nb_alive == 0);
+}
+
+namespace {
+
+struct INumbered {
+    virtual ~INumbered() noexcept {}
+    virtual auto number() const noexcept -> int = 0;
+};
+
+template <int N> struct Numbered final : INumbered {
+    auto number() const noexcept -> int override { return N; }
+};
+
+} // namespace
+
+TEST_CASE("SealedPoly with more than 8 types", "[utils][SealedPoly]") {
+    // the types past the 8th are dispatched by the switch
+    using Many =
+        jv::SealedPoly<INumbered, Numbered<0>, Numbered<1>, Numbered<2>,
+                       Numbered<3>, Numbered<4>, Numbered<5>, Numbered<6>,
+                       Numbered<7>, Numbered<8>, Numbered<9>>;
+    std::vector<Many> many;
+    many.emplace_back(Numbered<9>{});
+    many.emplace_back(Numbered<3>{});
+    many.emplace_back(Numbered<8>{});
+    many.emplace_back(Numbered<0>{});
+    many.emplace_back(Numbered<9>{}); // its vtable is known by now
+
+    std::vector<int> visited;
+    jv::for_each(many, [&](auto const& value) {
+        visited.push_back(std::decay_t<decltype(value)>{}.number());
+    });
+    CHECK(visited == std::vector<int>{9, 3, 8, 0, 9});
+    for (auto const& value : many)
+        CHECK(int(value.index()) == value->number());
+    CHECK(many[2].holds<Numbered<8>>());
+    CHECK(many[2].get_if<Numbered<9>>() == nullptr);
+
+    many[0].swap(many[1]);
+    CHECK(many[0].index() == 3);
+    CHECK(many[1].index() == 9);
+}
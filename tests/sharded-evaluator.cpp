@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <jv/bounded-poly.hpp>
+#include <jv/sharded-evaluator.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <sys/wait.h>
+
+namespace {
+
+struct IShape {
+    virtual ~IShape() noexcept {}
+    virtual auto area() const noexcept -> double = 0;
+};
+
+struct Square final : IShape {
+    double side;
+    Square(double s) noexcept : side(s) {}
+    auto area() const noexcept -> double override { return side * side; }
+    void encode(jv::WireWriter& out) const { out.write(side); }
+    static auto decode(jv::WireReader& in) -> Square {
+        return Square{in.read<double>()};
+    }
+};
+
+struct Rectangle final : IShape {
+    double width, height;
+    Rectangle(double w, double h) noexcept : width(w), height(h) {}
+    auto area() const noexcept -> double override { return width * height; }
+    void encode(jv::WireWriter& out) const {
+        out.write(width);
+        out.write(height);
+    }
+    static auto decode(jv::WireReader& in) -> Rectangle {
+        double const w = in.read<double>();
+        return Rectangle{w, in.read<double>()};
+    }
+};
+
+struct Unregistered final : IShape {
+    auto area() const noexcept -> double override { return 0; }
+};
+
+using Shape = jv::BoundedPoly<std::aligned_storage_t<24>, IShape>;
+
+auto make_registry() -> jv::WireRegistry<Shape> {
+    jv::WireRegistry<Shape> registry;
+    registry.add<Square>(1);
+    registry.add<Rectangle>(2);
+    return registry;
+}
+
+} // namespace
+
+TEST_CASE("ShardedEvaluator matches a local reduction",
+          "[utils][bounded-poly][ShardedEvaluator]") {
+    std::vector<Shape> shapes;
+    for (int i = 0; i < 1001; ++i) {
+        if (i % 3)
+            shapes.emplace_back(Square{double(i % 7)});
+        else
+            shapes.emplace_back(Rectangle{double(i % 5), 2});
+    }
+
+    auto registry = make_registry();
+    CHECK_THROWS_AS(registry.add<Square>(3), std::invalid_argument);
+
+    jv::ShardedEvaluator<Shape, double> evaluator{std::move(registry)};
+    auto const total_area = evaluator.add_reduction(
+        0.0, [](double acc, IShape const& s) { return acc + s.area(); },
+        [](double a, double b) { return a + b; });
+    auto const max_area = evaluator.add_reduction(
+        0.0,
+        [](double acc, IShape const& s) { return std::max(acc, s.area()); },
+        [](double a, double b) { return std::max(a, b); });
+    auto const picky = evaluator.add_reduction(
+        0.0,
+        [](double acc, IShape const& s) {
+            if (s.area() > 30)
+                throw std::domain_error{"too large"};
+            return acc;
+        },
+        [](double a, double) { return a; });
+
+    double const local_total = evaluator.evaluate(shapes, total_area);
+    double const local_max = evaluator.evaluate(shapes, max_area);
+
+    evaluator.start(3);
+    REQUIRE(evaluator.size() == 3);
+    CHECK(evaluator.evaluate(shapes, total_area) == Approx(local_total));
+    CHECK(evaluator.evaluate(shapes, max_area) == local_max);
+    CHECK_THROWS_AS(evaluator.evaluate(shapes, picky), std::runtime_error);
+    // the workers are still usable after a failed reduction
+    CHECK(evaluator.evaluate(shapes, total_area) == Approx(local_total));
+
+    std::vector<Shape> unknown;
+    unknown.emplace_back(Square{1});
+    unknown.emplace_back(Square{1});
+    unknown.emplace_back(Unregistered{}); // in the last shard
+    CHECK_THROWS_AS(evaluator.evaluate(unknown, total_area),
+                    std::invalid_argument);
+    CHECK(evaluator.size() == 3);
+    CHECK(evaluator.evaluate(shapes, total_area) == Approx(local_total));
+
+    evaluator.stop();
+    CHECK(evaluator.size() == 0);
+}
+
+TEST_CASE("ShardedEvaluator reaps its workers",
+          "[utils][bounded-poly][ShardedEvaluator]") {
+    {
+        jv::ShardedEvaluator<Shape, double> evaluator{make_registry()};
+        evaluator.start(2);
+        REQUIRE(evaluator.size() == 2);
+        CHECK(::waitpid(-1, nullptr, WNOHANG) == 0); // running children
+    }
+    // no child left, not even a zombie
+    errno = 0;
+    CHECK(::waitpid(-1, nullptr, WNOHANG) == -1);
+    CHECK(errno == ECHILD);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/sort-by-key.hpp>
+
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+int nb_moves = 0;
+
+struct IItem {
+    int key;
+    int rank; // creation order, to check stability
+    IItem(int k, int r) noexcept : key(k), rank(r) {}
+    IItem(IItem&& other) noexcept : key(other.key), rank(other.rank) {
+        ++nb_moves;
+    }
+    virtual ~IItem() noexcept {}
+    virtual auto name() const -> std::string = 0;
+};
+
+struct Small final : IItem {
+    using IItem::IItem;
+    auto name() const -> std::string override { return "small"; }
+};
+
+struct Large final : IItem {
+    char padding[40] = {};
+    using IItem::IItem;
+    auto name() const -> std::string override { return "large"; }
+};
+
+using Item = jv::BoundedPoly<std::aligned_union_t<0, Small, Large>, IItem>;
+
+auto make_items(int n) -> std::vector<Item> {
+    std::vector<Item> items;
+    items.reserve(n);
+    std::srand(1234);
+    for (int i = 0; i < n; ++i) {
+        int const key = std::rand() % 100 - 50;
+        if (i % 2)
+            items.emplace_back(Small{key, i});
+        else
+            items.emplace_back(Large{key, i});
+    }
+    return items;
+}
+
+auto sorted(std::vector<Item> const& items) -> bool {
+    for (std::size_t i = 1; i < items.size(); ++i) {
+        if (items[i - 1]->key > items[i]->key)
+            return false;
+        if (items[i - 1]->key == items[i]->key &&
+            items[i - 1]->rank > items[i]->rank)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("sort_by_key with integer keys", "[utils][bounded-poly][sort]") {
+    constexpr int N = 1000;
+    auto items = make_items(N);
+    nb_moves = 0;
+    jv::sort_by_key(items, [](Item const& item) { return item->key; });
+    CHECK(sorted(items));
+    // each element moves at most once, plus one move per cycle
+    CHECK(nb_moves <= N + N / 2);
+    CHECK(items.size() == std::size_t(N));
+    for (auto const& item : items)
+        CHECK(item->name() == (item->rank % 2 ? "small" : "large"));
+}
+
+TEST_CASE("sort_by_key with other keys", "[utils][bounded-poly][sort]") {
+    auto items = make_items(500);
+    jv::sort_by_key(items, [](Item const& item) { return double(item->key); });
+    CHECK(sorted(items));
+
+    std::vector<std::string> words{"pear", "apple", "fig", "apple", "kiwi"};
+    jv::sort_by_key(words, [](std::string const& w) { return w; });
+    CHECK(words == std::vector<std::string>{"apple", "apple", "fig", "kiwi",
+                                            "pear"});
+
+    std::vector<Item> empty;
+    jv::sort_by_key(empty, [](Item const& item) { return item->key; });
+    CHECK(empty.empty());
+}
+
+TEST_CASE("apply_permutation", "[utils][sort]") {
+    std::vector<int> values{10, 11, 12, 13, 14, 15};
+    std::vector<std::size_t> order{3, 0, 1, 2, 5, 4};
+    jv::apply_permutation(values.begin(), order);
+    CHECK(values == std::vector<int>{13, 10, 11, 12, 15, 14});
+    CHECK(order == std::vector<std::size_t>{0, 1, 2, 3, 4, 5});
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include <jv/thread-pool.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("ThreadPool::parallel_for", "[utils][ThreadPool]") {
+    for (std::size_t nb_workers : {0, 1, 3}) {
+        jv::ThreadPool pool{nb_workers};
+        REQUIRE(pool.size() == nb_workers + 1);
+
+        for (int round = 0; round < 10; ++round) {
+            std::vector<std::atomic<int>> hits(1000);
+            std::atomic<bool> chunks_ok{true}; // Catch is not thread-safe
+            pool.parallel_for(3, 1000, 7, [&](std::size_t first,
+                                              std::size_t last) {
+                if (last - first > 7)
+                    chunks_ok = false;
+                for (std::size_t i = first; i < last; ++i)
+                    ++hits[i];
+            });
+            int wrong = 0;
+            for (std::size_t i = 0; i < 1000; ++i)
+                wrong += hits[i] != (i >= 3 ? 1 : 0);
+            CHECK(wrong == 0);
+            CHECK(chunks_ok);
+        }
+
+        CHECK_THROWS_AS(pool.parallel_for(0, 100, 1,
+                                          [](std::size_t first, std::size_t) {
+                                              if (first == 42)
+                                                  throw std::runtime_error{
+                                                      "42"};
+                                          }),
+                        std::runtime_error);
+    }
+}
+
+TEST_CASE("ThreadPool runs nested loops inline", "[utils][ThreadPool]") {
+    jv::ThreadPool pool{2};
+    jv::ThreadPool other{1};
+    std::vector<std::atomic<int>> hits(100 * 100);
+    pool.parallel_for(0, 100, 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t i = first; i < last; ++i)
+            pool.parallel_for(0, 100, 10, [&](std::size_t f, std::size_t l) {
+                // a loop of another pool, inside, still works
+                other.parallel_for(f, l, 1, [&](std::size_t g, std::size_t) {
+                    // from a worker of `other`, while `pool` is busy
+                    std::atomic<int> n{0};
+                    pool.parallel_for(0, 8, 1,
+                                      [&](std::size_t, std::size_t) { ++n; });
+                    hits[i * 100 + g] += n == 8;
+                });
+            });
+    });
+    int wrong = 0;
+    for (auto const& hit : hits)
+        wrong += hit != 1;
+    CHECK(wrong == 0);
+}
@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <jv/bounded-poly.hpp>
+#include <jv/poly-vector.hpp>
+#include <jv/vtable-mover.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+struct IAnimal {
+    virtual ~IAnimal() noexcept {}
+    virtual auto name() const -> std::string = 0;
+};
+
+// no move_to method
+struct Dog final : IAnimal {
+    std::unique_ptr<std::string> nickname; // move-only
+    Dog(std::string n) : nickname(std::make_unique<std::string>(n)) {}
+    auto name() const -> std::string override { return "dog " + *nickname; }
+};
+
+struct Cat : IAnimal {
+    auto name() const -> std::string override { return "cat"; }
+};
+
+struct Lion final : Cat {
+    int roar = 3;
+    auto name() const -> std::string override { return "lion"; }
+};
+
+template <int K> struct Bird final : IAnimal {
+    auto name() const -> std::string override {
+        return "bird" + std::to_string(K);
+    }
+};
+
+using Animal = jv::BoundedPoly<std::aligned_union_t<0, Dog, Lion>, IAnimal,
+                               jv::VtableMover<IAnimal>>;
+
+} // namespace
+
+TEST_CASE("VtableMover", "[utils][bounded-poly][VtableMover]") {
+    static_assert(sizeof(Animal) == sizeof(std::aligned_union_t<0, Dog, Lion>));
+    // registered by the noexcept members of BoundedPoly, so cannot throw
+    STATIC_REQUIRE(noexcept(jv::VtableMover<IAnimal>::register_type<Dog>(
+        std::declval<IAnimal const&>())));
+
+    Animal a{Dog{"rex"}};
+    Animal b{std::in_place_type_t<Cat>{}};
+    Animal c{std::move(a)};
+    CHECK(c->name() == "dog rex");
+
+    b.swap(c);
+    CHECK(b->name() == "dog rex");
+    CHECK(c->name() == "cat");
+
+    c.emplace<Lion>();
+    c = std::move(b);
+    CHECK(c->name() == "dog rex");
+    b = Lion{};
+    CHECK(b->name() == "lion");
+
+    jv::PolyVector<Animal> animals;
+    for (int i = 0; i < 100; ++i) { // several reallocations
+        if (i % 2)
+            animals.push_back(Dog{std::to_string(i)});
+        else
+            animals.emplace_back<Lion>();
+    }
+    animals.erase(0);
+    CHECK(animals[0]->name() == "dog 1");
+    CHECK(animals[98]->name() == "dog 99");
+}
+
+TEST_CASE("VtableMover registration from several threads",
+          "[utils][bounded-poly][VtableMover]") {
+    using Flyer = jv::BoundedPoly<std::aligned_storage_t<16>, IAnimal,
+                                  jv::VtableMover<IAnimal>>;
+    std::atomic<int> wrong{0};
+    auto work = [&](auto... tags) {
+        for (int round = 0; round < 100; ++round) {
+            std::vector<Flyer> birds;
+            (birds.emplace_back(decltype(tags){}), ...);
+            std::vector<Flyer> moved{};
+            for (Flyer& bird : birds)
+                moved.push_back(std::move(bird));
+            std::string const name = moved.back()->name();
+            wrong += name.compare(0, 4, "bird") != 0;
+        }
+    };
+    std::thread t1{[&] { work(Bird<1>{}, Bird<2>{}, Bird<3>{}, Bird<4>{}); }};
+    std::thread t2{[&] { work(Bird<5>{}, Bird<6>{}, Bird<7>{}, Bird<1>{}); }};
+    work(Bird<8>{}, Bird<9>{}, Bird<10>{}, Bird<11>{}, Bird<12>{}, Bird<13>{},
+         Bird<14>{}, Bird<15>{}, Bird<16>{}, Bird<17>{}, Bird<18>{});
+    t1.join();
+    t2.join();
+    CHECK(wrong == 0);
+}